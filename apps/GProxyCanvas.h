@@ -16,6 +16,11 @@ public:
     void save() override { if (fProxy) fProxy->save(); }
     void restore() override { if (fProxy) fProxy->restore(); }
     void concat(const GMatrix& m) override { if (fProxy) fProxy->concat(m); }
+    void clipRect(const GRect& r) override { if (fProxy) fProxy->clipRect(r); }
+    void clipPath(const GPath& p) override { if (fProxy) fProxy->clipPath(p); }
+    bool quickReject(const GRect& r) const override { return fProxy && fProxy->quickReject(r); }
+    bool takeDirtyRect(GIRect* r) override { return fProxy && fProxy->takeDirtyRect(r); }
+    void flush() override { if (fProxy) fProxy->flush(); }
 
     void drawPaint(const GPaint& p) override {
         if (this->allowDraw()) {
@@ -41,8 +46,56 @@ public:
         }
     }
 
+    // Batches still ask allowDraw() once per draw, and pass on each run of allowed draws as a batch
+
+    void drawRects(const GRect rects[], const GPaint paints[], int count) override {
+        this->forEachAllowedRun(count, [&](int i, int n) {
+            fProxy->drawRects(rects + i, paints + i, n);
+        });
+    }
+
+    void drawConvexPolygons(const GPoint pts[], const int counts[], const GPaint paints[],
+                            int polyCount) override {
+        const GPoint* runPts = pts;
+        int runStart = 0;
+        this->forEachAllowedRun(polyCount, [&](int i, int n) {
+            for (; runStart < i; ++runStart) {
+                runPts += counts[runStart];
+            }
+            fProxy->drawConvexPolygons(runPts, counts + i, paints + i, n);
+        });
+    }
+
+    void drawPaths(const GPath* const paths[], const GPaint paints[], int count) override {
+        this->forEachAllowedRun(count, [&](int i, int n) {
+            fProxy->drawPaths(paths + i, paints + i, n);
+        });
+    }
+
+    void drawPathInstances(const GPath& path, const GMatrix matrices[], const GPaint paints[],
+                           int n) override {
+        this->forEachAllowedRun(n, [&](int i, int runCount) {
+            fProxy->drawPathInstances(path, matrices + i, paints + i, runCount);
+        });
+    }
+
 private:
     GCanvas* fProxy;
+
+    // Call allowDraw() for each of count draws, and proc(first, count) for each run of them
+    // that is allowed.
+    template <typename Proc> void forEachAllowedRun(int count, Proc proc) {
+        int start = 0;
+        for (int i = 0; i <= count; ++i) {
+            if (i < count && this->allowDraw()) {
+                continue;
+            }
+            if (i > start) {
+                proc(start, i - start);
+            }
+            start = i + 1;
+        }
+    }
 };
 
 #endif
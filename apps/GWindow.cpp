@@ -7,6 +7,7 @@
 #include "../include/GCanvas.h"
 #include "../include/GRect.h"
 #include "../include/GTime.h"
+#include <algorithm>
 #include <stdio.h>
 
 GClick::GClick(GPoint loc, std::function<void(GClick*)> func) : fFunc(func) {
@@ -18,6 +19,14 @@ GWindow::GWindow(int width, int height) {
     fClick = NULL;
     fWidth = width;
     fHeight = height;
+    fNeedDraw = false;
+    fInvalAll = true;
+    fInval = GRect::LTRB(0, 0, 0, 0);
+    fNeedFullUpload = true;
+    fLastUploadBytes = 0;
+    fTotalUploadBytes = 0;
+    fRenderer = nullptr;
+    fTexture = nullptr;
 
     this->setupBitmap(width, height);
     fCanvas = GCreateCanvas(fBitmap);
@@ -27,6 +36,13 @@ GWindow::GWindow(int width, int height) {
                                SDL_WINDOWPOS_UNDEFINED,
                                SDL_WINDOWPOS_UNDEFINED,
                                width, height, flags);
+    if (!fWindow) {
+        // e.g. SDL_VIDEODRIVER=dummy has no OpenGL, but can still render in software
+        fWindow = SDL_CreateWindow("An SDL2 window",
+                                   SDL_WINDOWPOS_UNDEFINED,
+                                   SDL_WINDOWPOS_UNDEFINED,
+                                   width, height, flags & ~SDL_WINDOW_OPENGL);
+    }
     if (!fWindow) {
         printf("Can't create window: %s\n", SDL_GetError());
         return;
@@ -59,7 +75,23 @@ void GWindow::pushEvent(int code) const {
 }
 
 void GWindow::requestDraw() {
+    fInvalAll = true;
+    if (!fNeedDraw) {
+        fNeedDraw = true;
+        this->pushEvent(42);
+    }
+}
+
+void GWindow::requestDraw(const GRect& area) {
+    if (!fNeedDraw || fInval.isEmpty()) {
+        fInval = area;
+    } else {
+        fInval = GRect::LTRB(std::min(fInval.left, area.left), std::min(fInval.top, area.top),
+                             std::max(fInval.right, area.right),
+                             std::max(fInval.bottom, area.bottom));
+    }
     if (!fNeedDraw) {
+        fInvalAll = false;
         fNeedDraw = true;
         this->pushEvent(42);
     }
@@ -84,6 +116,8 @@ bool GWindow::handleEvent(const SDL_Event& evt) {
                     this->setupBitmap(fWidth, fHeight);
                     fCanvas = GCreateCanvas(fBitmap);
                     fNeedDraw = true;
+                    fInvalAll = true;
+                    fNeedFullUpload = true;
                     return true;
             }
             break;
@@ -162,6 +196,37 @@ void GWindow::onUpdate(const GBitmap& bitmap, GCanvas* canvas) {
     this->onDraw(canvas);
 }
 
+bool GWindow::update() {
+    if (!fNeedDraw) {
+        return false;
+    }
+    fNeedDraw = false;  // clear this before we call onDraw
+
+    fCanvas->save();
+    if (!fInvalAll) {
+        fCanvas->clipRect(fInval);
+    }
+    this->onUpdate(fBitmap, fCanvas.get());
+    fCanvas->restore();
+    fCanvas->flush();
+
+    GIRect dirty;
+    if (!fCanvas->takeDirtyRect(&dirty) || fNeedFullUpload) {
+        dirty = GIRect::WH(fWidth, fHeight);
+    }
+    fNeedFullUpload = false;
+
+    fLastUploadBytes = 0;
+    if (!dirty.isEmpty()) {
+        SDL_Rect r = make(dirty);
+        SDL_UpdateTexture(fTexture, &r, fBitmap.getAddr(dirty.left, dirty.top),
+                          fBitmap.rowBytes());
+        fLastUploadBytes = (size_t)dirty.width() * dirty.height() * sizeof(GPixel);
+    }
+    fTotalUploadBytes += fLastUploadBytes;
+    return true;
+}
+
 int GWindow::run() {
     if (!fWindow) {
         return -1;
@@ -172,12 +237,7 @@ int GWindow::run() {
     SDL_Event e;
     while (SDL_WaitEvent(&e) && e.type != SDL_QUIT) {
         this->handleEvent(e);
-
-        if (fNeedDraw) {
-            fNeedDraw = false;  // clear this before we call onDraw
-            this->onUpdate(fBitmap, fCanvas.get());
-            SDL_UpdateTexture(fTexture, nullptr, fBitmap.pixels(), fBitmap.rowBytes());
-        }
+        this->update();
         SDL_RenderCopy(fRenderer, fTexture, nullptr, nullptr);
         this->onDrawOverlays();
 
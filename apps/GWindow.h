@@ -10,10 +10,10 @@
 
 #include "../include/GBitmap.h"
 #include "../include/GPoint.h"
+#include "../include/GRect.h"
 
 class GCanvas;
 class GClick;
-class GIRect;
 
 class GWindow {
 public:
@@ -21,6 +21,17 @@ public:
 
     void requestDraw();
 
+    // Only area (in window coordinates) needs redrawing; the next onDraw() is clipped to it
+    void requestDraw(const GRect& area);
+
+    // If a draw was requested, draw and copy the changed pixels to the window's texture.
+    // run() calls this for each event; returns true if it drew.
+    bool update();
+
+    // Bytes copied from the bitmap to the texture by the most recent update(), and in total
+    size_t lastUploadBytes() const { return fLastUploadBytes; }
+    size_t totalUploadBytes() const { return fTotalUploadBytes; }
+
 protected:
     GWindow(int initial_width, int initial_height);
     virtual ~GWindow();
@@ -47,6 +58,11 @@ private:
     int fWidth;
     int fHeight;
     bool fNeedDraw;
+    bool fInvalAll;         // else only fInval needs to be drawn
+    GRect fInval;
+    bool fNeedFullUpload;   // the texture is new, so the canvas' dirty rect is not enough
+    size_t fLastUploadBytes;
+    size_t fTotalUploadBytes;
 
     SDL_Window*   fWindow;
     SDL_Renderer* fRenderer;
@@ -6,7 +6,14 @@
 #include "../include/GCanvas.h"
 #include "../include/GBitmap.h"
 #include "../include/GTime.h"
+#include "../src/GCpu.h"
+#include "../src/GEdge.h"
+#include "../src/GMaskCache.h"
+#include "../src/GPaintAnalysis.h"
+#include "../src/GQuickReject.h"
+#include <atomic>
 #include <memory>
+#include <new>
 #include <string>
 #include <vector>
 #include <sys/stat.h>
@@ -14,6 +21,26 @@
 
 constexpr double gMaxBenchMultiplier = 32;   // times slower than mine
 
+// Every heap allocation in the program (including GArena's blocks) goes through here, so that
+// we can see which canvases still allocate once they are warmed up.
+static std::atomic<int> gHeapAllocs{0};
+
+void* operator new(size_t size) {
+    gHeapAllocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
 static void setup_bitmap(GBitmap* bitmap, int w, int h) {
     size_t rb = w * sizeof(GPixel);
     bitmap->reset(w, h, rb, (GPixel*)calloc(h, rb), GBitmap::kNo_IsOpaque);
@@ -25,11 +52,15 @@ enum Mode {
     kOnce,
 };
 
-static double handle_proc(GBenchmark* bench, const char path[], GBitmap* bitmap, Mode mode) {
+// Returns the time per loop. *allocs is the number of heap allocations per loop, after the
+// first (untimed) draw has warmed up the canvas.
+static double handle_proc(GBenchmark* bench, const char path[], GBitmap* bitmap, Mode mode,
+                          int* loops, int* allocs) {
     GISize size = bench->size();
     setup_bitmap(bitmap, size.width, size.height);
 
-    auto canvas = GCreateCanvas(*bitmap);
+    const int threads = bench->threadCount();
+    auto canvas = threads > 0 ? GCreateCanvas(*bitmap, threads) : GCreateCanvas(*bitmap);
     if (!canvas) {
         fprintf(stderr, "failed to create canvas for [%d %d] %s\n",
                 size.width, size.height, bench->name());
@@ -48,14 +79,67 @@ static double handle_proc(GBenchmark* bench, const char path[], GBitmap* bitmap,
         case kOnce: N = 4; break;
     }
 
+    bench->draw(canvas.get());
+    canvas->flush();
+    GPaintAnalysis_ResetCounts();
+    GQuickReject_ResetCounts();
+    GEdge_ResetCounts();
+    GMaskCache_ResetCounts();
+
+    const int allocsBefore = gHeapAllocs.load(std::memory_order_relaxed);
     GMSec now = GTime::GetMSec();
     for (int i = 0; i < N || forever; ++i) {
         bench->draw(canvas.get());
+        canvas->flush();
     }
     GMSec dur = GTime::GetMSec() - now;
+    *allocs = (gHeapAllocs.load(std::memory_order_relaxed) - allocsBefore) / N;
+    *loops = N;
     return dur * 1.0 / N;
 }
 
+// Which paint reductions (see GPaintAnalysis.h) fired, per call to bench->draw()
+static void print_paint_reductions(int loops) {
+    if (GPaintAnalysis_DrawCount() == 0 || loops <= 0) {
+        return;    // the canvas does not analyze its paints
+    }
+    printf(" [draws %d", GPaintAnalysis_DrawCount() / loops);
+    for (int i = 0; i <= static_cast<int>(GPaintReduction::kLast); ++i) {
+        const auto r = static_cast<GPaintReduction>(i);
+        if (int count = GPaintAnalysis_Count(r)) {
+            printf(" %s %d", GPaintReduction_Name(r), count / loops);
+        }
+    }
+    printf("]");
+}
+
+static void print_quick_rejects(int loops) {
+    const int rejected = GQuickReject_RejectCount(),
+              accepted = GQuickReject_AcceptCount();
+    if (rejected + accepted == 0 || loops <= 0) {
+        return;    // the canvas does not quick-reject
+    }
+    printf(" [reject %d accept %d]", rejected / loops, accepted / loops);
+}
+
+static void print_edges(int loops, double dur) {
+    const int edges = GEdge_Count();
+    if (edges == 0 || loops <= 0 || dur <= 0) {
+        return;    // the canvas does not use GEdge
+    }
+    // dur is milliseconds per loop
+    printf(" [edges %d %.1fM/s]", edges / loops, edges / loops / dur * 1e-3);
+}
+
+static void print_masks(int loops) {
+    const int hits = GMaskCache_HitCount(),
+              misses = GMaskCache_MissCount();
+    if (hits + misses == 0 || loops <= 0) {
+        return;    // the canvas does not cache masks
+    }
+    printf(" [masks hit %d miss %d]", hits / loops, misses / loops);
+}
+
 static bool is_arg(const char arg[], const char name[]) {
     std::string str("--");
     str += name;
@@ -94,9 +178,13 @@ int main_bench(int argc, const char* argv[]) {
     std::vector<double> inScores;
     bool chatty_mode = true;
     bool write_images = false;
+    bool zero_allocs = false;   // fail if any bench allocates after warming up
+    bool extra = false;         // also run gExtraBenchFactories (after the scored ones)
 
     int count = -1;
     while (gBenchFactories[++count]);
+    int extraCount = -1;
+    while (gExtraBenchFactories[++extraCount]);
 
     for (int i = 1; i < argc; ++i) {
         if (is_arg(argv[i], "once")) {
@@ -118,6 +206,17 @@ int main_bench(int argc, const char* argv[]) {
             chatty_mode = false;
         } else if (is_arg(argv[i], "writeImages")) {
             write_images = true;
+        } else if (is_arg(argv[i], "zeroAllocs")) {
+            zero_allocs = true;
+        } else if (is_arg(argv[i], "extra")) {
+            extra = true;
+        } else if (is_arg(argv[i], "cpu") && i+1 < argc) {
+            GCpuLevel level;
+            if (!GCpu_ParseName(argv[++i], &level)) {
+                printf("Unknown cpu level %s\n", argv[i]);
+                return -1;
+            }
+            GCpu_SetLevel(level);
         } else {
             printf("Unknown arg %s\n", argv[i]);
             return -1;
@@ -129,10 +228,18 @@ int main_bench(int argc, const char* argv[]) {
         return -1;
     }
 
+    if (chatty_mode) {
+        printf("cpu %s (detected %s)\n", GCpu_Name(GCpu_Level()), GCpu_Name(GCpu_Detect()));
+    }
+
     std::vector<double> durs;
     double quotient = 0;
-    for (int i = 0; i < count; ++i) {
-        std::unique_ptr<GBenchmark> bench(gBenchFactories[i]());
+    double singleThreadDur = 0;  // for reporting the speedup of the threaded variants
+    int allocatingBenches = 0;
+    for (int i = 0; i < count + (extra ? extraCount : 0); ++i) {
+        const bool scored = i < count;
+        std::unique_ptr<GBenchmark> bench(scored ? gBenchFactories[i]()
+                                                 : gExtraBenchFactories[i - count]());
         const char* name = bench->name();
         
         if (match && !strstr(name, match)) {
@@ -140,21 +247,43 @@ int main_bench(int argc, const char* argv[]) {
         }
 
         GBitmap testBM;
-        double dur = handle_proc(bench.get(), name, &testBM, mode);
+        int loops = 0, allocs = 0;
+        double dur = handle_proc(bench.get(), name, &testBM, mode, &loops, &allocs);
         if (chatty_mode) {
             printf("%s %g", name, dur);
         }
-        if (inScores.size()) {
+        if (inScores.size() && scored) {
             double quo = std::min(dur / inScores[i], gMaxBenchMultiplier);
             if (chatty_mode) {
                 printf(" %g [%.2f]", inScores[i], quo);
             }
             quotient += quo;
         }
+        if (bench->threadCount() == 1) {
+            singleThreadDur = dur;
+        }
+        if (chatty_mode && bench->threadCount() > 1 && singleThreadDur > 0 && dur > 0) {
+            printf(" x%.2f", singleThreadDur / dur);
+        }
+        if (chatty_mode) {
+            print_paint_reductions(loops);
+            print_quick_rejects(loops);
+            print_edges(loops, dur);
+            print_masks(loops);
+            if (allocs > 0) {
+                printf(" [allocs %d]", allocs);
+            }
+        }
         if (chatty_mode) {
             printf("\n");
         }
-        durs.push_back(dur);
+        if (zero_allocs && allocs > 0) {
+            printf("%s: %d heap allocations per loop, expected none\n", name, allocs);
+            allocatingBenches += 1;
+        }
+        if (scored) {
+            durs.push_back(dur);
+        }
 
         if (write_images) {
             std::string str(name);
@@ -164,6 +293,11 @@ int main_bench(int argc, const char* argv[]) {
         free(testBM.pixels());
     }
 
+    if (allocatingBenches > 0) {
+        printf("FAILED: %d benches allocate after warming up\n", allocatingBenches);
+        return -1;
+    }
+
     if (inScores.size()) {
         printf("score %.2f\n", quotient / count);
         if (scoreFile) {
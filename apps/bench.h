@@ -17,6 +17,9 @@ public:
     virtual GISize size() const = 0;
     virtual void draw(GCanvas*) = 0;
 
+    // If > 0, the canvas is created with GCreateCanvas(bitmap, threadCount)
+    virtual int threadCount() const { return 0; }
+
     typedef GBenchmark* (*Factory)();
 };
 
@@ -25,4 +28,10 @@ public:
  */
 extern const GBenchmark::Factory gBenchFactories[];
 
+/*
+ *  More benches, only run with --extra. They are not part of the score, so adding to them
+ *  does not change what existing score files (--inScores) line up with.
+ */
+extern const GBenchmark::Factory gExtraBenchFactories[];
+
 #endif
@@ -8,12 +8,15 @@
 #include "../include/GColor.h"
 #include "../include/GRandom.h"
 #include "../include/GRect.h"
+#include "../include/GRecordingCanvas.h"
+#include "../src/GBlend.h"
 #include <string>
 
 #include "bench_pa1.inc"
 #include "bench_pa2.inc"
 #include "bench_pa3.inc"
 #include "bench_pa4.inc"
+#include "bench_pa5.inc"
 
 const GBenchmark::Factory gBenchFactories[] {
     []() -> GBenchmark* { return new ClearBench(); },
@@ -58,3 +61,120 @@ const GBenchmark::Factory gBenchFactories[] {
 
     nullptr,
 };
+
+const GBenchmark::Factory gExtraBenchFactories[] {
+    []() -> GBenchmark* { return new GradientModesBench(); },
+
+    // pa5
+    []() -> GBenchmark* { return new TiledLionBench(1); },
+    []() -> GBenchmark* { return new TiledLionBench(2); },
+    []() -> GBenchmark* { return new TiledLionBench(4); },
+    []() -> GBenchmark* { return new TiledLionBench(8); },
+    []() -> GBenchmark* { return new ReplayBench(new RectsBench(false)); },
+    []() -> GBenchmark* { return new ReplayBench(new PathBench("path_big", 1.0f, false)); },
+
+    // the same scenes inside a clip
+    []() -> GBenchmark* { return new ClippedBench(new RectsBench(false), ClippedBench::kRect); },
+    []() -> GBenchmark* { return new ClippedBench(new RectsBench(false), ClippedBench::kPath); },
+    []() -> GBenchmark* {
+        return new ClippedBench(new PathBench("path_big", 1.0f, false), ClippedBench::kRect);
+    },
+    []() -> GBenchmark* {
+        return new ClippedBench(new PathBench("path_big", 1.0f, false), ClippedBench::kPath);
+    },
+
+    // drawPath scaling: contour count, then points per contour
+    []() -> GBenchmark* { return new PathBench("path_c1_p10",   1.0f, false,   1,  10); },
+    []() -> GBenchmark* { return new PathBench("path_c4_p10",   1.0f, false,   4,  10); },
+    []() -> GBenchmark* { return new PathBench("path_c16_p10",  1.0f, false,  16,  10); },
+    []() -> GBenchmark* { return new PathBench("path_c64_p10",  1.0f, false,  64,  10); },
+    []() -> GBenchmark* { return new PathBench("path_c10_p4",   1.0f, false,  10,   4); },
+    []() -> GBenchmark* { return new PathBench("path_c10_p40",  1.0f, false,  10,  40); },
+    []() -> GBenchmark* { return new PathBench("path_c10_p160", 1.0f, false,  10, 160); },
+
+    // anti-aliased fills, to compare with their aliased versions
+    []() -> GBenchmark* { return new CirclesBench(false, true); },
+    []() -> GBenchmark* { return new CirclesBench(true,  true); },
+    []() -> GBenchmark* { return new PathBench("path_small_aa", 0.1f, false, 10, 10, true); },
+    []() -> GBenchmark* { return new PathBench("path_big_aa",   1.0f, false, 10, 10, true); },
+    []() -> GBenchmark* { return new PathBench("path_bigc_aa",  1.0f,  true, 10, 10, true); },
+
+    // opaque rects can be filled with plain row stores
+    []() -> GBenchmark* {
+        return new SingleRectBench({2,2}, GRect::LTRB(-1000, -1000, 1002, 1002),
+                                   "rect_big_opaque", true);
+    },
+    []() -> GBenchmark* {
+        return new SingleRectBench({1000,1000}, GRect::LTRB(500, 500, 502, 502),
+                                   "rect_tiny_opaque", true);
+    },
+
+    // per-mode throughput, through the canvas and then just the blend procs
+    []() -> GBenchmark* { return new SingleModeBench(GBlendMode::kClear); },
+    []() -> GBenchmark* { return new SingleModeBench(GBlendMode::kSrc); },
+    []() -> GBenchmark* { return new SingleModeBench(GBlendMode::kDst); },
+    []() -> GBenchmark* { return new SingleModeBench(GBlendMode::kSrcOver); },
+    []() -> GBenchmark* { return new SingleModeBench(GBlendMode::kDstOver); },
+    []() -> GBenchmark* { return new SingleModeBench(GBlendMode::kSrcIn); },
+    []() -> GBenchmark* { return new SingleModeBench(GBlendMode::kDstIn); },
+    []() -> GBenchmark* { return new SingleModeBench(GBlendMode::kSrcOut); },
+    []() -> GBenchmark* { return new SingleModeBench(GBlendMode::kDstOut); },
+    []() -> GBenchmark* { return new SingleModeBench(GBlendMode::kSrcATop); },
+    []() -> GBenchmark* { return new SingleModeBench(GBlendMode::kDstATop); },
+    []() -> GBenchmark* { return new SingleModeBench(GBlendMode::kXor); },
+    []() -> GBenchmark* { return new BlendProcBench(GBlendMode::kClear); },
+    []() -> GBenchmark* { return new BlendProcBench(GBlendMode::kSrc); },
+    []() -> GBenchmark* { return new BlendProcBench(GBlendMode::kDst); },
+    []() -> GBenchmark* { return new BlendProcBench(GBlendMode::kSrcOver); },
+    []() -> GBenchmark* { return new BlendProcBench(GBlendMode::kDstOver); },
+    []() -> GBenchmark* { return new BlendProcBench(GBlendMode::kSrcIn); },
+    []() -> GBenchmark* { return new BlendProcBench(GBlendMode::kDstIn); },
+    []() -> GBenchmark* { return new BlendProcBench(GBlendMode::kSrcOut); },
+    []() -> GBenchmark* { return new BlendProcBench(GBlendMode::kDstOut); },
+    []() -> GBenchmark* { return new BlendProcBench(GBlendMode::kSrcATop); },
+    []() -> GBenchmark* { return new BlendProcBench(GBlendMode::kDstATop); },
+    []() -> GBenchmark* { return new BlendProcBench(GBlendMode::kXor); },
+
+    // the same draws as rects_* and quads_*, in one batched call
+    []() -> GBenchmark* { return new RectsBench(false, true); },
+    []() -> GBenchmark* { return new RectsBench(true,  true); },
+    []() -> GBenchmark* { return new PolyRectsBench(false, true); },
+    []() -> GBenchmark* { return new PolyRectsBench(true,  true); },
+
+    // one path, many instances
+    []() -> GBenchmark* { return new PathInstancesBench(PathInstancesBench::kColors, false); },
+    []() -> GBenchmark* { return new PathInstancesBench(PathInstancesBench::kColors, true); },
+    []() -> GBenchmark* { return new PathInstancesBench(PathInstancesBench::kTranslate, false); },
+    []() -> GBenchmark* { return new PathInstancesBench(PathInstancesBench::kTranslate, true); },
+    []() -> GBenchmark* { return new PathInstancesBench(PathInstancesBench::kRotate, false); },
+    []() -> GBenchmark* { return new PathInstancesBench(PathInstancesBench::kRotate, true); },
+
+    // the same lion paths every frame (lion_tiles_1 makes new ones), so they can be cached
+    []() -> GBenchmark* { return new ReplayBench(new TiledLionBench(1)); },
+
+    // single 4K shader draws, serial and split into bands of rows
+    []() -> GBenchmark* {
+        return new BitmapBench("apps/spock.png", "bitmap_opaque_4k_1", 2, {3840, 2160}, 1);
+    },
+    []() -> GBenchmark* {
+        return new BitmapBench("apps/spock.png", "bitmap_opaque_4k_4", 2, {3840, 2160}, 4);
+    },
+    []() -> GBenchmark* {
+        const GColor colors[] = {{ 1, 0, 0, 1 }, { 0, 1, 1, 1 }, {0, 1, 0, 0}};
+        return new GradientBench(colors, 3, "gradient_3_4k_1", 2, {3840, 2160}, 1);
+    },
+    []() -> GBenchmark* {
+        const GColor colors[] = {{ 1, 0, 0, 1 }, { 0, 1, 1, 1 }, {0, 1, 0, 0}};
+        return new GradientBench(colors, 3, "gradient_3_4k_4", 2, {3840, 2160}, 4);
+    },
+
+    // recorded every frame (with the list recycled), and recorded inside a clip path
+    []() -> GBenchmark* { return new RecordBench(new RectsBench(false)); },
+    []() -> GBenchmark* { return new RecordBench(new PathBench("path_big", 1.0f, false)); },
+    []() -> GBenchmark* {
+        return new RecordBench(new ClippedBench(new PathBench("path_big", 1.0f, false),
+                                                ClippedBench::kPath));
+    },
+
+    nullptr,
+};
@@ -147,6 +147,19 @@ public:
         }
     }
 
+    // Everything draw() and drawHilite() can touch
+    GRect getDrawBounds() {
+        GRect r = this->getRect();
+        if (fGradient) {
+            for (const GPoint& p : fGradPts) {
+                r = GRect::LTRB(std::min(r.left, p.x), std::min(r.top, p.y),
+                                std::max(r.right, p.x), std::max(r.bottom, p.y));
+            }
+        }
+        const float pad = 4;    // antialiasing, the hilite corners and points
+        return GRect::LTRB(r.left - pad, r.top - pad, r.right + pad, r.bottom + pad);
+    }
+
     void offset(float dx, float dy) {
         this->setRect(this->getRect().offset(dx, dy));
 
@@ -463,9 +476,11 @@ protected:
                 return new GClick(loc, [this](GClick* click) {
                     const GPoint curr = click->curr();
                     const GPoint prev = click->prev();
+                    // only where the shape was, and where it is now, needs to be redrawn
+                    this->requestDraw(fShape->getDrawBounds());
                     fShape->offset(curr.x - prev.x, curr.y - prev.y);
                     this->updateTitle();
-                    this->requestDraw();
+                    this->requestDraw(fShape->getDrawBounds());
                 });
             }
         }
@@ -6,6 +6,8 @@
 #include "../include/GCanvas.h"
 #include "../include/GColor.h"
 #include "../include/GBitmap.h"
+#include "../include/GThreadPool.h"
+#include "../src/GBandReplay.h"
 #include <string>
 
 static int pixel_diff(GPixel p0, GPixel p1) {
@@ -69,12 +71,43 @@ static void handle_proc(const GDrawRec& rec, const char path[], GBitmap* bitmap)
 
     canvas->clear({0, 0, 0, 0});
     rec.fDraw(canvas.get());
+    canvas->flush();
 
     if (!bitmap->writeToFile(path)) {
         fprintf(stderr, "failed to write %s\n", path);
     }
 }
 
+/*
+ *  Draw the rec again in bands (see GDrawInBands), each band on its own canvas, and compare it
+ *  to the serial render. The bands draw with the same device coordinates, so they must match
+ *  exactly (no --tolerance). Return how many pixels differ (or -1 if it could not be drawn),
+ *  and set maxDiff to the largest difference in a component.
+ */
+static int check_bands(const GDrawRec& rec, const GBitmap& serial, int bands, GThreadPool* pool,
+                       int* maxDiff) {
+    GBitmap bitmap;
+    bitmap.alloc(rec.fWidth, rec.fHeight);
+    int diffs = -1;
+    *maxDiff = 0;
+    const bool drawn = GDrawInBands(bitmap, bands, pool, [&rec](GCanvas* canvas) {
+        canvas->clear({0, 0, 0, 0});
+        rec.fDraw(canvas);
+    });
+    if (drawn) {
+        diffs = 0;
+        for (int y = 0; y < bitmap.height(); ++y) {
+            for (int x = 0; x < bitmap.width(); ++x) {
+                const int diff = pixel_diff(*bitmap.getAddr(x, y), *serial.getAddr(x, y));
+                diffs += diff > 0;
+                *maxDiff = std::max(*maxDiff, diff);
+            }
+        }
+    }
+    free(bitmap.pixels());
+    return diffs;
+}
+
 static bool is_arg(const char arg[], const char name[]) {
     std::string str("--");
     str += name;
@@ -135,6 +168,7 @@ static void handle_something(FILE* f, std::string prefix, const char dir[], int
     auto canvas = GCreateCanvas(bitmap);
     if (canvas) {
         std::string title = GDrawSomething(canvas.get(), {256, 256});
+        canvas->flush();
         std::string filename = prefix + "something.png";
         bitmap.writeToFile(filename.c_str());
         printf("Title: '%s'\n", title.c_str());
@@ -199,6 +233,8 @@ int main_image(int argc, const char* argv[]) {
     FILE* diffFile = NULL;
     int tolerance = 0;
     bool append_pa_prefix = true;
+    int bands = 0;
+    int bandMismatches = 0;
 
     const char* collage_dir = nullptr;
     int collage_index = -1;
@@ -223,6 +259,8 @@ int main_image(int argc, const char* argv[]) {
         } else if (is_arg(argv[i], "tolerance") && i+1 < argc) {
             tolerance = atoi(argv[++i]);
             assert(tolerance >= 0);
+        } else if (is_arg(argv[i], "bands") && i+1 < argc) {
+            bands = atoi(argv[++i]);
         } else if (is_arg(argv[i], "scoreFile") && i+1 < argc) {
             scoreFile = argv[++i];
         } else if (is_arg(argv[i], "diff") && i+1 < argc) {
@@ -257,6 +295,12 @@ int main_image(int argc, const char* argv[]) {
     // pa#_NAME.png -- so add 8 to the name length for the total
     const int maxNameLen = max_name_len() + 8;
 
+    // --bands N also renders each rec in N bands at once, which must match the serial render
+    std::unique_ptr<GThreadPool> pool;
+    if (bands > 0) {
+        pool.reset(new GThreadPool(bands));
+    }
+
     double percent_correct = 0;
     double counter = 0;
     for (int i = 0; gDrawRecs[i].fDraw; ++i) {
@@ -287,6 +331,19 @@ int main_image(int argc, const char* argv[]) {
         GBitmap testBM;
         handle_proc(gDrawRecs[i], path.c_str(), &testBM);
 
+        if (bands > 0 && testBM.pixels()) {
+            int maxDiff;
+            const int diffs = check_bands(gDrawRecs[i], testBM, bands, pool.get(), &maxDiff);
+            if (diffs < 0) {
+                bandMismatches += 1;
+                printf("- %s in %d bands: failed to draw\n", gDrawRecs[i].fName, bands);
+            } else if (diffs > 0) {
+                bandMismatches += 1;
+                printf("- %s in %d bands: %d pixels differ, by up to %d\n",
+                       gDrawRecs[i].fName, bands, diffs, maxDiff);
+            }
+        }
+
         if (expected && !something) {
             std::string exp_path(expected);
             exp_path += "/";
@@ -321,6 +378,10 @@ int main_image(int argc, const char* argv[]) {
     if (expected) {
         printf("           image: %d\n", image_score);
     }
+    if (bands > 0) {
+        printf("           bands: %d %s\n", bands,
+               bandMismatches ? "MISMATCH" : "match serial");
+    }
     if (scoreFile) {
         FILE* f = fopen(scoreFile, "w");
         if (f) {
@@ -331,5 +392,5 @@ int main_image(int argc, const char* argv[]) {
             return -1;
         }
     }
-    return 0;
+    return bandMismatches ? -1 : 0;
 }
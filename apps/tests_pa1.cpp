@@ -47,6 +47,7 @@ static void test_clear(GTestStats* stats) {
         auto canvas = GCreateCanvas(bm);
         force_fill_pixels(bm, 0x12345678);  // init with garbage
         canvas->clear(r.color);
+        canvas->flush();
         EXPECT_TRUE(stats, expect_pixels_value(bm, r.pixel));
     }
 }
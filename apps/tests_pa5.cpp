@@ -0,0 +1,2117 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "../include/GCanvas.h"
+#include "../include/GBitmap.h"
+#include "../include/GPathBuilder.h"
+#include "../include/GShader.h"
+#include "../include/GRandom.h"
+#include "../include/GRecordingCanvas.h"
+#include "../include/GThreadPool.h"
+#include "../src/GAxisRect.h"
+#include "../src/GBandReplay.h"
+#include "../src/GBlend.h"
+#include "../src/GBlitter.h"
+#include "../src/GClipStack.h"
+#include "../src/GCpu.h"
+#include "../src/GDeferredClear.h"
+#include "../src/GDirtyRect.h"
+#include "../src/GEdge.h"
+#include "../src/GEdgeCache.h"
+#include "../src/GMaskCache.h"
+#include "../src/GPaintAnalysis.h"
+#include "../src/GParallelRows.h"
+#include "../src/GQuickReject.h"
+#include "../src/GScanConverter.h"
+#include "tests.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+static bool same_pixels(const GBitmap& a, const GBitmap& b) {
+    assert(a.width() == b.width() && a.height() == b.height());
+    for (int y = 0; y < a.height(); ++y) {
+        if (memcmp(a.getAddr(0, y), b.getAddr(0, y), a.width() * sizeof(GPixel))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// touches many tiles, with rects, polygons, paths, and shaders
+static void draw_tile_scene(GCanvas* canvas, GBlendMode mode) {
+    canvas->clear({0.25f, 0.5f, 0.75f, 0.5f});
+
+    GPaint paint;
+    paint.setBlendMode(mode);
+
+    GRandom rand;
+    for (int i = 0; i < 20; ++i) {
+        paint.setRGBA(rand.nextF(), rand.nextF(), rand.nextF(), rand.nextF());
+        float x = rand.nextF() * 300 - 20,
+              y = rand.nextF() * 200 - 20;
+        canvas->drawRect(GRect::XYWH(x, y, rand.nextF() * 150, rand.nextF() * 150), paint);
+    }
+
+    canvas->save();
+    canvas->translate(150, 100);
+    canvas->rotate(0.3f);
+    const GPoint tri[] = {{-120, -80}, {130, -20}, {-10, 90}};
+    paint.setRGBA(1, 0, 0, 0.75f);
+    canvas->drawConvexPolygon(tri, 3, paint);
+
+    GPathBuilder bu;
+    bu.addRect(GRect::LTRB(-100, -60, 100, 60));
+    bu.addRect(GRect::LTRB(-50, -30, 50, 30), GPathDirection::kCCW);
+    paint.setShader(GCreateLinearGradient({-100, 0}, {100, 0}, {0, 1, 0, 1}, {0, 0, 1, 0.25f}));
+    canvas->drawPath(*bu.detach(), paint);
+    canvas->restore();
+}
+
+static void test_tile_canvas(GTestStats* stats) {
+    const int w = 300, h = 200;
+    GBitmap serialBM, tiledBM;
+    serialBM.alloc(w, h);
+    tiledBM.alloc(w, h);
+
+    for (int m = 0; m < 12; ++m) {
+        const GBlendMode mode = static_cast<GBlendMode>(m);
+        {
+            auto canvas = GCreateCanvas(serialBM);
+            draw_tile_scene(canvas.get(), mode);
+        }
+        auto canvas = GCreateCanvas(tiledBM, 4);
+        EXPECT_PTR(stats, canvas.get());
+        if (canvas) {
+            draw_tile_scene(canvas.get(), mode);
+            canvas->flush();
+            EXPECT_TRUE(stats, same_pixels(serialBM, tiledBM));
+        }
+    }
+
+    // saves, concats and clips made before a flush still apply after it
+    auto serial = GCreateCanvas(serialBM);
+    auto tiled = GCreateCanvas(tiledBM, 3);
+    const GPoint tri[] = {{0, 0}, {150, 0}, {0, 150}};
+    GPathBuilder bu;
+    bu.addPolygon(tri, 3);
+    const auto clip = bu.detach();
+    for (GCanvas* canvas : {serial.get(), tiled.get()}) {
+        canvas->clear({1, 1, 1, 1});
+        canvas->save();
+        canvas->translate(40, 30);
+        canvas->clipRect(GRect::WH(200, 120));
+        canvas->save();
+        canvas->clipPath(*clip);
+        canvas->flush();
+        canvas->drawRect(GRect::WH(w, h), GPaint({1, 0, 0, 0.5f}));
+        canvas->flush();
+        canvas->restore();
+        canvas->drawRect(GRect::LTRB(100, 80, 300, 300), GPaint({0, 0, 1, 1}));
+        canvas->flush();
+        canvas->restore();
+        canvas->drawRect(GRect::WH(10, 10), GPaint({0, 1, 0, 1}));
+        canvas->flush();
+    }
+    EXPECT_TRUE(stats, same_pixels(serialBM, tiledBM));
+    EXPECT_EQ(stats, *tiledBM.getAddr(5, 5), GPixel_PackARGB(0xFF, 0, 0xFF, 0));
+    EXPECT_EQ(stats, GPixel_GetR(*tiledBM.getAddr(45, 35)), 0xFF);
+    EXPECT_EQ(stats, GPixel_GetG(*tiledBM.getAddr(180, 100)), 0xFF);    // outside the path
+    EXPECT_EQ(stats, *tiledBM.getAddr(150, 120), GPixel_PackARGB(0xFF, 0, 0, 0xFF));
+    EXPECT_EQ(stats, *tiledBM.getAddr(250, 160), 0xFFFFFFFF);           // outside the rect
+
+    free(serialBM.pixels());
+    free(tiledBM.pixels());
+}
+
+static void test_thread_pool(GTestStats* stats) {
+    for (int threads : {1, 2, 8}) {
+        GThreadPool pool(threads);
+        EXPECT_EQ(stats, pool.threadCount(), threads);
+
+        std::atomic<int> sum{0};
+        pool.parallelFor(100, [&](int i) { sum += i; });
+        EXPECT_EQ(stats, sum.load(), 4950);
+
+        // tasks may add more tasks
+        sum = 0;
+        for (int i = 0; i < 10; ++i) {
+            pool.add([&]() {
+                for (int j = 0; j < 10; ++j) {
+                    pool.add([&]() { sum += 1; });
+                }
+            });
+        }
+        pool.wait();
+        EXPECT_EQ(stats, sum.load(), 100);
+
+        // a task may run (and wait for) a parallelFor of its own, even inside another one
+        sum = 0;
+        pool.parallelFor(8, [&](int) {
+            pool.parallelFor(8, [&](int) {
+                pool.parallelFor(4, [&](int) { sum += 1; });
+            });
+        });
+        EXPECT_EQ(stats, sum.load(), 256);
+        for (int i = 0; i < 4; ++i) {
+            pool.add([&]() {
+                pool.parallelFor(10, [&](int j) { sum += j; });
+            });
+        }
+        pool.wait();
+        EXPECT_EQ(stats, sum.load(), 256 + 4 * 45);
+    }
+}
+
+namespace {
+// Remembers which path object each drawPath() and clipPath() was given
+class PathSpyCanvas : public GCanvas {
+public:
+    std::vector<const GPath*> fPaths;
+
+    void save() override {}
+    void restore() override {}
+    void concat(const GMatrix&) override {}
+    void clipPath(const GPath& path) override { fPaths.push_back(&path); }
+    void clear(const GColor&) override {}
+    void drawRect(const GRect&, const GPaint&) override {}
+    void drawConvexPolygon(const GPoint[], int, const GPaint&) override {}
+    void drawPath(const GPath& path, const GPaint&) override { fPaths.push_back(&path); }
+};
+}  // namespace
+
+static void test_recording(GTestStats* stats) {
+    GRecordingCanvas recorder;
+    auto empty = recorder.finishRecording();
+    EXPECT_EQ(stats, empty->count(), 0);
+
+    for (int m = 0; m < 12; ++m) {
+        draw_tile_scene(&recorder, static_cast<GBlendMode>(m));
+    }
+    auto list = recorder.finishRecording();
+    // clear + 20 rects + save + concat*2 + poly + path + restore
+    EXPECT_EQ(stats, list->count(), 12 * 27);
+    EXPECT_TRUE(stats, list->op(0) == GDisplayList::Op::kClear);
+    EXPECT_TRUE(stats, list->op(26) == GDisplayList::Op::kRestore);
+    EXPECT_EQ(stats, recorder.finishRecording()->count(), 0);
+
+    const int w = 300, h = 200;
+    GBitmap directBM, replayBM;
+    directBM.alloc(w, h);
+    replayBM.alloc(w, h);
+    for (int m = 0; m < 12; ++m) {
+        draw_tile_scene(GCreateCanvas(directBM).get(), static_cast<GBlendMode>(m));
+    }
+    auto canvas = GCreateCanvas(replayBM);
+    list->playback(canvas.get());
+    canvas->flush();
+    EXPECT_TRUE(stats, same_pixels(directBM, replayBM));
+
+    // unbalanced saves do not leak out of playback
+    recorder.save();
+    recorder.translate(1000, 1000);
+    recorder.finishRecording()->playback(canvas.get());
+    canvas->drawRect(GRect::WH(1, 1), GPaint({0, 0, 0, 1}));
+    canvas->flush();
+    EXPECT_EQ(stats, *replayBM.getAddr(0, 0), GPixel_PackARGB(0xFF, 0, 0, 0));
+
+    // nor do unbalanced restores pop the caller's saves
+    recorder.save();
+    recorder.restore();
+    recorder.restore();
+    recorder.restore();
+    auto extra = recorder.finishRecording();
+    EXPECT_EQ(stats, extra->count(), 2);
+    canvas->save();
+    canvas->translate(1000, 1000);
+    extra->playback(canvas.get());
+    canvas->drawRect(GRect::WH(1, 1), GPaint({0, 0, 1, 1}));
+    canvas->restore();
+    canvas->flush();
+    EXPECT_EQ(stats, *replayBM.getAddr(0, 0), GPixel_PackARGB(0xFF, 0, 0, 0));
+
+    // a save from a previous recording does not balance a restore in this one
+    recorder.save();
+    recorder.finishRecording();
+    recorder.restore();
+    EXPECT_EQ(stats, recorder.finishRecording()->count(), 0);
+
+    // each path is copied once, and shared by every record of it, here and in the next list
+    GPathBuilder bu;
+    bu.addRect(GRect::LTRB(1, 2, 30, 40));
+    auto p = bu.detach();
+    bu.addRect(GRect::LTRB(5, 6, 7, 8));
+    auto q = bu.detach();
+    const uint32_t pID = p->uniqueID();
+    const GPaint paint;
+    recorder.clipPath(*p);
+    recorder.drawPath(*p, paint);
+    recorder.drawPath(*q, paint);
+    auto first = recorder.finishRecording();
+    recorder.drawPath(*p, paint);
+    auto second = recorder.finishRecording();
+    recorder.drawPath(*q, paint);
+    recorder.finishRecording();     // does not use p, so the next one copies it again
+    recorder.drawPath(*p, paint);
+    auto fourth = recorder.finishRecording();
+    p.reset();      // the lists own their copies
+    q.reset();
+    PathSpyCanvas spy;
+    for (const auto& list : {first.get(), second.get(), fourth.get()}) {
+        list->playback(&spy);
+    }
+    const auto& seen = spy.fPaths;
+    EXPECT_EQ(stats, (int)seen.size(), 5);
+    if (seen.size() == 5) {
+        EXPECT_TRUE(stats, seen[0] == seen[1] && seen[0] == seen[3]);
+        EXPECT_TRUE(stats, seen[2] != seen[0] && seen[4] != seen[0]);
+        EXPECT_TRUE(stats, seen[0]->uniqueID() == pID && seen[4]->uniqueID() == pID);
+        EXPECT_TRUE(stats, seen[0]->bounds().right == 30 && seen[2]->bounds().right == 7);
+    }
+
+    // a recycled list is emptied, and holds the recording after the current one
+    const GDisplayList* storage = first.get();
+    recorder.recycle(std::move(first));
+    recorder.clear({0, 0, 0, 0});
+    EXPECT_TRUE(stats, recorder.finishRecording().get() != storage);
+    recorder.drawRect(GRect::WH(1, 1), paint);
+    auto reused = recorder.finishRecording();
+    EXPECT_TRUE(stats, reused.get() == storage && reused->count() == 1 &&
+                       reused->op(0) == GDisplayList::Op::kDrawRect);
+
+    free(directBM.pixels());
+    free(replayBM.pixels());
+}
+
+static void test_path_winding(GTestStats* stats) {
+    const GPaint paint({0, 0, 1, 0.5f});
+
+    // what one layer of the paint looks like
+    GBitmap ref;
+    ref.alloc(1, 1);
+    auto refCanvas = GCreateCanvas(ref);
+    refCanvas->drawRect(GRect::WH(1, 1), paint);
+    refCanvas->flush();
+    const GPixel once = *ref.getAddr(0, 0);
+    free(ref.pixels());
+
+    GBitmap bm;
+    bm.alloc(30, 30);
+    auto canvas = GCreateCanvas(bm);
+
+    // overlapping contours in the same direction: winding 2 is covered once, not twice
+    GPathBuilder bu;
+    bu.addRect(GRect::LTRB(0, 0, 10, 10));
+    bu.addRect(GRect::LTRB(5, 5, 15, 15));
+    canvas->drawPath(*bu.detach(), paint);
+    canvas->flush();
+    EXPECT_EQ(stats, *bm.getAddr(2, 2), once);
+    EXPECT_EQ(stats, *bm.getAddr(7, 7), once);
+    EXPECT_EQ(stats, *bm.getAddr(12, 12), once);
+    EXPECT_EQ(stats, *bm.getAddr(12, 2), 0u);
+
+    // opposite directions cancel, leaving a hole
+    bu.addRect(GRect::LTRB(16, 0, 30, 14));
+    bu.addRect(GRect::LTRB(20, 4, 26, 10), GPathDirection::kCCW);
+    canvas->drawPath(*bu.detach(), paint);
+    canvas->flush();
+    EXPECT_EQ(stats, *bm.getAddr(17, 1), once);
+    EXPECT_EQ(stats, *bm.getAddr(22, 6), 0u);
+
+    // a self-intersecting star: the center has winding 2, and is filled
+    const GPoint star[] = {{23, 16}, {27.7f, 29}, {16.5f, 21}, {29.5f, 21}, {18.3f, 29}};
+    bu.addPolygon(star, GARRAY_COUNT(star));
+    canvas->drawPath(*bu.detach(), paint);
+    canvas->flush();
+    EXPECT_EQ(stats, *bm.getAddr(23, 23), once);
+    EXPECT_EQ(stats, *bm.getAddr(16, 28), 0u);
+
+    free(bm.pixels());
+}
+
+static bool near_alpha(GPixel p, int alpha, int tolerance = 1) {
+    return std::abs(GPixel_GetA(p) - alpha) <= tolerance;
+}
+
+static void test_antialias(GTestStats* stats) {
+    GBitmap bm;
+    bm.alloc(4, 2);
+    auto canvas = GCreateCanvas(bm);
+    GPaint paint({0, 0, 0, 1});
+
+    // aliased: only the pixels whose centers are inside are drawn
+    const GPoint quad[] = {{0.5f, 0}, {2.5f, 0}, {2.5f, 1}, {0.5f, 1}};
+    canvas->drawConvexPolygon(quad, 4, paint);
+    canvas->flush();
+    EXPECT_EQ(stats, *bm.getAddr(0, 0), 0u);
+    EXPECT_EQ(stats, *bm.getAddr(1, 0), 0xFF000000);
+    EXPECT_EQ(stats, *bm.getAddr(2, 0), 0xFF000000);
+
+    // anti-aliased: the half-covered pixels get half of the paint
+    canvas->clear({0, 0, 0, 0});
+    paint.setAntiAlias(true);
+    canvas->drawConvexPolygon(quad, 4, paint);
+    canvas->flush();
+    EXPECT_TRUE(stats, near_alpha(*bm.getAddr(0, 0), 128));
+    EXPECT_EQ(stats, *bm.getAddr(1, 0), 0xFF000000);
+    EXPECT_TRUE(stats, near_alpha(*bm.getAddr(2, 0), 128));
+    EXPECT_EQ(stats, *bm.getAddr(3, 0), 0u);
+    EXPECT_EQ(stats, *bm.getAddr(1, 1), 0u);
+
+    // exact area (not a sample count) for a diagonal edge
+    canvas->clear({0, 0, 0, 0});
+    GPathBuilder bu;
+    const GPoint tri[] = {{0, 0}, {2, 0}, {0, 2}};
+    bu.addPolygon(tri, 3);
+    canvas->drawPath(*bu.detach(), paint);
+    canvas->flush();
+    EXPECT_EQ(stats, *bm.getAddr(0, 0), 0xFF000000);
+    EXPECT_TRUE(stats, near_alpha(*bm.getAddr(1, 0), 128));
+    EXPECT_TRUE(stats, near_alpha(*bm.getAddr(0, 1), 128));
+    EXPECT_EQ(stats, *bm.getAddr(1, 1), 0u);
+
+    // coverage goes through the blend mode: kSrc at half coverage is half src, half dst
+    canvas->clear({1, 0, 0, 1});
+    paint.setColor({0, 0, 0, 0});
+    paint.setBlendMode(GBlendMode::kSrc);
+    canvas->drawConvexPolygon(quad, 4, paint);
+    canvas->flush();
+    EXPECT_TRUE(stats, near_alpha(*bm.getAddr(0, 0), 127) && GPixel_GetR(*bm.getAddr(0, 0)) ==
+                                                             GPixel_GetA(*bm.getAddr(0, 0)));
+    EXPECT_EQ(stats, *bm.getAddr(1, 0), 0u);
+    EXPECT_EQ(stats, *bm.getAddr(3, 0), 0xFFFF0000);
+
+    free(bm.pixels());
+}
+
+static void test_blitter(GTestStats* stats) {
+    bool exact = true;
+    for (unsigned a = 0; a <= 255; ++a) {
+        for (unsigned b = 0; b <= 255; ++b) {
+            exact &= GMulDiv255(a, b) == (a * b + 127) / 255;
+        }
+    }
+    EXPECT_TRUE(stats, exact);
+
+    const GPixel red = GPixel_PackARGB(0xFF, 0xFF, 0, 0);
+    GBitmap bm;
+    bm.alloc(8, 6);
+    GOpaqueStoreBlitter blitter(bm, red);
+
+    blitter.blitRect(2, 1, 3, 4);
+    int count = 0;
+    visit_pixels(bm, [&](int x, int y, GPixel* p) {
+        bool inside = x >= 2 && x < 5 && y >= 1 && y < 5;
+        count += (*p == (inside ? red : 0));
+    });
+    EXPECT_EQ(stats, count, 8 * 6);
+
+    // full-width rects take the contiguous path
+    blitter.blitRect(0, 5, 8, 1);
+    EXPECT_EQ(stats, *bm.getAddr(0, 5), red);
+    EXPECT_EQ(stats, *bm.getAddr(7, 5), red);
+
+    const GAlphaRun runs[] = {{1, 0x80}, {2, 0xFF}, {1, 0}, {1, 0x40}, {0, 0}};
+    blitter.blitAntiH(1, 0, runs);
+    EXPECT_EQ(stats, *bm.getAddr(0, 0), 0u);
+    EXPECT_EQ(stats, *bm.getAddr(1, 0), GPixel_PackARGB(0x80, 0x80, 0, 0));
+    EXPECT_EQ(stats, *bm.getAddr(2, 0), red);
+    EXPECT_EQ(stats, *bm.getAddr(3, 0), red);
+    EXPECT_EQ(stats, *bm.getAddr(4, 0), 0u);
+    EXPECT_EQ(stats, *bm.getAddr(5, 0), GPixel_PackARGB(0x40, 0x40, 0, 0));
+    EXPECT_EQ(stats, *bm.getAddr(6, 0), 0u);
+
+    free(bm.pixels());
+}
+
+static GPixel rand_premul(GRandom& rand) {
+    unsigned a = rand.nextU() & 0xFF;
+    if (rand.nextU() & 1) {
+        a = (rand.nextU() & 1) ? 0xFF : 0;  // make the edge cases common
+    }
+    return GPixel_PackARGB(a, rand.nextRange(0, a), rand.nextRange(0, a), rand.nextRange(0, a));
+}
+
+// the formulas from GBlendMode.h, in floats
+static float ref_blend(GBlendMode mode, float s, float sa, float d, float da) {
+    switch (mode) {
+        case GBlendMode::kClear:    return 0;
+        case GBlendMode::kSrc:      return s;
+        case GBlendMode::kDst:      return d;
+        case GBlendMode::kSrcOver:  return s + (1 - sa)*d;
+        case GBlendMode::kDstOver:  return d + (1 - da)*s;
+        case GBlendMode::kSrcIn:    return da * s;
+        case GBlendMode::kDstIn:    return sa * d;
+        case GBlendMode::kSrcOut:   return (1 - da)*s;
+        case GBlendMode::kDstOut:   return (1 - sa)*d;
+        case GBlendMode::kSrcATop:  return da*s + (1 - sa)*d;
+        case GBlendMode::kDstATop:  return sa*d + (1 - da)*s;
+        case GBlendMode::kXor:      return (1 - sa)*d + (1 - da)*s;
+    }
+    return 0;
+}
+
+static bool matches_formula(GBlendMode mode, GPixel s, GPixel d, GPixel result) {
+    const float sa = GPixel_GetA(s) / 255.0f,
+                da = GPixel_GetA(d) / 255.0f;
+    for (int shift = 0; shift < 32; shift += 8) {
+        float expected = ref_blend(mode, ((s >> shift) & 0xFF) / 255.0f, sa,
+                                         ((d >> shift) & 0xFF) / 255.0f, da) * 255;
+        if (std::abs(expected - ((result >> shift) & 0xFF)) > 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_blend_procs(GTestStats* stats) {
+    GRandom rand;
+    for (int m = 0; m < 12; ++m) {
+        const GBlendMode mode = static_cast<GBlendMode>(m);
+        bool formula = true, procs_agree = true;
+        for (int i = 0; i < 2000; ++i) {
+            const GPixel s = rand_premul(rand),
+                         d = rand_premul(rand);
+            const GPixel result = GBlendPixel(mode, s, d);
+            formula &= matches_formula(mode, s, d, result);
+
+            GPixel r0 = d, r1 = d;
+            GChooseBlendColorProc(mode, s)(&r0, s, 1);
+            GChooseBlendRowProc(mode)(&r1, &s, 1);
+            procs_agree &= r0 == result && r1 == result;
+        }
+        EXPECT_TRUE(stats, formula);
+        EXPECT_TRUE(stats, procs_agree);
+    }
+}
+
+// Every set of procs this cpu can run must match the scalar ones exactly, including the tails
+static void test_blend_simd(GTestStats* stats) {
+    const struct {
+        GCpuLevel          fLevel;
+        const GBlendProcs* fProcs;
+    } sets[] = {
+        { GCpuLevel::kSSE2,   GBlendProcs_SSE2()   },
+        { GCpuLevel::kAVX2,   GBlendProcs_AVX2()   },
+        { GCpuLevel::kAVX512, GBlendProcs_AVX512() },
+    };
+    const GBlendProcs* scalar = GBlendProcs_Scalar();
+    const int n = 37;   // not a multiple of any register width
+    GRandom rand;
+    GPixel src[n], dst[n], expected[n], actual[n];
+    for (const auto& set : sets) {
+        const GBlendProcs* procs = set.fProcs;
+        if (!procs || set.fLevel > GCpu_Detect()) {
+            continue;
+        }
+        for (int m = 0; m < 12; ++m) {
+            bool same = true;
+            for (int count = 0; count <= n; ++count) {
+                for (int i = 0; i < n; ++i) {
+                    src[i] = rand_premul(rand);
+                    dst[i] = rand_premul(rand);
+                }
+                const GPixel colors[] = { src[0] | 0xFF000000, src[1] };
+                for (int k = 0; k < 2; ++k) {
+                    memcpy(expected, dst, sizeof(dst));
+                    memcpy(actual, dst, sizeof(dst));
+                    const auto& want = k ? scalar->fTranslucentColor : scalar->fOpaqueColor;
+                    const auto& have = k ? procs->fTranslucentColor : procs->fOpaqueColor;
+                    want[m](expected, colors[k], count);
+                    have[m](actual, colors[k], count);
+                    same &= memcmp(expected, actual, sizeof(dst)) == 0;
+                }
+                memcpy(expected, dst, sizeof(dst));
+                memcpy(actual, dst, sizeof(dst));
+                scalar->fRow[m](expected, src, count);
+                procs->fRow[m](actual, src, count);
+                same &= memcmp(expected, actual, sizeof(dst)) == 0;
+            }
+            EXPECT_TRUE(stats, same);
+        }
+    }
+}
+
+class RowShader : public GShader {
+    const GPixel* fRow;
+    const bool    fOpaque;
+public:
+    RowShader(const GPixel row[], bool opaque = false) : fRow(row), fOpaque(opaque) {}
+    bool isOpaque() override { return fOpaque; }
+    bool setContext(const GMatrix&) override { return true; }
+    void shadeRow(int x, int y, int count, GPixel row[]) override {
+        memcpy(row, fRow + x, count * sizeof(GPixel));
+    }
+};
+
+static void test_choose_blitter(GTestStats* stats) {
+    const int w = 300;  // wider than the shader blitter's chunk
+    GRandom rand;
+    std::vector<GPixel> srcRow(w), dstRow(w);
+    for (int i = 0; i < w; ++i) {
+        srcRow[i] = rand_premul(rand);
+        dstRow[i] = rand_premul(rand);
+    }
+    RowShader shader(srcRow.data());
+    const GPixel colors[] = { GPixel_PackARGB(0xFF, 0x10, 0x20, 0x30),
+                              GPixel_PackARGB(0x80, 0x10, 0x20, 0x30) };
+
+    GBitmap bm;
+    bm.alloc(w, 1);
+    GArena arena;
+    for (int m = 0; m < 12; ++m) {
+        const GBlendMode mode = static_cast<GBlendMode>(m);
+        bool same = true;
+        for (GPixel c : colors) {
+            memcpy(bm.pixels(), dstRow.data(), w * sizeof(GPixel));
+            GChooseBlitter(bm, mode, c, nullptr, &arena)->blitH(0, 0, w);
+            for (int i = 0; i < w; ++i) {
+                same &= *bm.getAddr(i, 0) == GBlendPixel(mode, c, dstRow[i]);
+            }
+        }
+        memcpy(bm.pixels(), dstRow.data(), w * sizeof(GPixel));
+        GChooseBlitter(bm, mode, 0, &shader, &arena)->blitH(0, 0, w);
+        for (int i = 0; i < w; ++i) {
+            same &= *bm.getAddr(i, 0) == GBlendPixel(mode, srcRow[i], dstRow[i]);
+        }
+        EXPECT_TRUE(stats, same);
+        arena.reset();
+    }
+    free(bm.pixels());
+}
+
+// Forcing each level (as G_CPU_LEVEL does) must not change any pixels
+static void test_cpu_levels(GTestStats* stats) {
+    const int w = 300;
+    GRandom rand;
+    std::vector<GPixel> srcRow(w), dstRow(w);
+    for (int i = 0; i < w; ++i) {
+        srcRow[i] = rand_premul(rand);
+        dstRow[i] = rand_premul(rand);
+    }
+    RowShader shader(srcRow.data());
+    const GPixel color = GPixel_PackARGB(0x80, 0x10, 0x20, 0x30);
+
+    GBitmap bm;
+    bm.alloc(w, 1);
+    GArena arena;
+    const GCpuLevel original = GCpu_Level();
+    for (int l = 0; l <= static_cast<int>(GCpu_Detect()); ++l) {
+        const GCpuLevel level = static_cast<GCpuLevel>(l);
+        EXPECT_TRUE(stats, GCpu_SetLevel(level) == level && GCpu_Level() == level);
+        if (level == GCpuLevel::kScalar) {
+            // the procs chosen by earlier draws (at the detected level) are not reused
+            const int srcOver = static_cast<int>(GBlendMode::kSrcOver);
+            EXPECT_TRUE(stats, GChooseBlendRowProc(GBlendMode::kSrcOver) ==
+                               GBlendProcs_Scalar()->fRow[srcOver]);
+        }
+
+        bool same = true;
+        for (int m = 0; m < 12; ++m) {
+            const GBlendMode mode = static_cast<GBlendMode>(m);
+            memcpy(bm.pixels(), dstRow.data(), w * sizeof(GPixel));
+            GChooseBlitter(bm, mode, color, nullptr, &arena)->blitH(0, 0, w);
+            for (int i = 0; i < w; ++i) {
+                same &= *bm.getAddr(i, 0) == GBlendPixel(mode, color, dstRow[i]);
+            }
+            memcpy(bm.pixels(), dstRow.data(), w * sizeof(GPixel));
+            GChooseBlitter(bm, mode, 0, &shader, &arena)->blitH(0, 0, w);
+            for (int i = 0; i < w; ++i) {
+                same &= *bm.getAddr(i, 0) == GBlendPixel(mode, srcRow[i], dstRow[i]);
+            }
+            arena.reset();
+        }
+        EXPECT_TRUE(stats, same);
+    }
+    // a level above the cpu's is clamped
+    EXPECT_TRUE(stats, GCpu_SetLevel(GCpuLevel::kAVX512) == GCpu_Detect());
+
+    GCpuLevel parsed;
+    EXPECT_TRUE(stats, GCpu_ParseName("sse41", &parsed) && parsed == GCpuLevel::kSSE41);
+    EXPECT_TRUE(stats, !GCpu_ParseName("neon", &parsed));
+
+    GCpu_SetLevel(original);
+    free(bm.pixels());
+}
+
+// Drawing with the reduced paint (or not at all, if skipped) must give the same pixels
+static void test_paint_analysis(GTestStats* stats) {
+    const int n = 64;
+    GRandom rand;
+    GPixel dst[n], opaqueDst[n], transparentDst[n] = {}, shaded[n], opaqueShaded[n];
+    for (int i = 0; i < n; ++i) {
+        dst[i] = rand_premul(rand);
+        opaqueDst[i] = dst[i] | 0xFF000000;
+        shaded[i] = rand_premul(rand);
+        opaqueShaded[i] = shaded[i] | 0xFF000000;
+    }
+    auto shader = std::make_shared<RowShader>(shaded);
+    auto opaqueShader = std::make_shared<RowShader>(opaqueShaded, true);
+
+    const struct {
+        GPaint        fPaint;
+        const GPixel* fSrc;     // what the paint draws, for each dst pixel
+    } paints[] = {
+        { GPaint(GColor::RGBA(1, 0.5f, 0.25f, 1)), nullptr },
+        { GPaint(GColor::RGBA(1, 0.5f, 0.25f, 0.5f)), nullptr },
+        { GPaint(GColor::RGBA(1, 0.5f, 0.25f, 0)), nullptr },
+        { GPaint(shader), shaded },
+        { GPaint(opaqueShader), opaqueShaded },
+    };
+    // the premul pixels for the colors above
+    const GPixel colors[] = { GPixel_PackARGB(0xFF, 0xFF, 0x80, 0x40),
+                              GPixel_PackARGB(0x80, 0x80, 0x40, 0x20), 0 };
+
+    const struct {
+        GDstState     fState;
+        const GPixel* fDst;
+    } dsts[] = {
+        { GDstState::Unknown(),     dst            },
+        { GDstState::Constant(0),   transparentDst },
+        { GDstState::Opaque(),      opaqueDst      },
+    };
+
+    int skipped = 0;
+    for (const auto& d : dsts) {
+        for (int p = 0; p < GARRAY_COUNT(paints); ++p) {
+            for (int m = 0; m < 12; ++m) {
+                GPaint paint = paints[p].fPaint;
+                paint.setBlendMode(static_cast<GBlendMode>(m));
+                const GPaintAnalysis analysis = GAnalyzePaint(paint, d.fState);
+                skipped += analysis.fSkip;
+
+                bool same = analysis.fShader == nullptr || analysis.fShader == paint.peekShader();
+                for (int i = 0; i < n; ++i) {
+                    const GPixel src = paints[p].fSrc ? paints[p].fSrc[i] : colors[p];
+                    const GPixel expected = GBlendPixel(paint.getBlendMode(), src, d.fDst[i]);
+                    const GPixel actual = analysis.fSkip
+                                        ? d.fDst[i]
+                                        : GBlendPixel(analysis.fMode, src, d.fDst[i]);
+                    same &= expected == actual;
+                }
+                EXPECT_TRUE(stats, same);
+            }
+        }
+    }
+    EXPECT_TRUE(stats, skipped > 20);
+
+    GPaintAnalysis_ResetCounts();
+    GPaint paint(opaqueShader);
+    GAnalyzePaint(paint.setBlendMode(GBlendMode::kSrcOver));
+    GAnalyzePaint(paint.setBlendMode(GBlendMode::kClear));
+    EXPECT_EQ(stats, GPaintAnalysis_DrawCount(), 2);
+    EXPECT_EQ(stats, GPaintAnalysis_Count(GPaintReduction::kOpaqueSrcOver), 1);
+    EXPECT_EQ(stats, GPaintAnalysis_Count(GPaintReduction::kClearShader), 1);
+    EXPECT_EQ(stats, GPaintAnalysis_Count(GPaintReduction::kDstNoop), 0);
+
+    GPaint translucent(GColor::RGBA(1, 0.5f, 0.25f, 0.5f));
+    EXPECT_TRUE(stats, GAnalyzePaint(translucent, GDstState::Constant(0)).fMode == GBlendMode::kSrc);
+    EXPECT_EQ(stats, GPaintAnalysis_Count(GPaintReduction::kTransparentDstStore), 1);
+    translucent.setBlendMode(GBlendMode::kDstOver);
+    EXPECT_TRUE(stats, GAnalyzePaint(translucent, GDstState::Opaque()).fSkip);
+    EXPECT_EQ(stats, GPaintAnalysis_Count(GPaintReduction::kOpaqueDstNoop), 1);
+    GPaintAnalysis_ResetCounts();
+}
+
+static void test_dst_tracker(GTestStats* stats) {
+    const int B = GDstTracker::kBandRows;
+    GDstTracker tracker(4 * B);
+    EXPECT_TRUE(stats, tracker.query(0, 4 * B).fKind == GDstState::kUnknown);
+
+    tracker.clear(0);
+    EXPECT_TRUE(stats, tracker.query(0, 4 * B).isTransparent());
+
+    // a translucent draw into band 1 only
+    tracker.didDraw(B + 1, B + 3, GBlendMode::kSrc, false);
+    EXPECT_TRUE(stats, tracker.query(0, B).isTransparent());
+    EXPECT_TRUE(stats, tracker.query(2 * B, 4 * B).isTransparent());
+    EXPECT_TRUE(stats, tracker.query(0, 4 * B).fKind == GDstState::kUnknown);
+
+    // opaque stays opaque under kSrcOver, whatever the src
+    const GPixel white = 0xFFFFFFFF;
+    tracker.clear(white);
+    tracker.didDraw(0, B, GBlendMode::kSrcOver, false);
+    EXPECT_TRUE(stats, tracker.query(0, B).fKind == GDstState::kOpaque);
+    EXPECT_TRUE(stats, tracker.query(B, 2 * B).fKind == GDstState::kConstant);
+    EXPECT_TRUE(stats, tracker.query(0, 2 * B).isOpaque());
+    EXPECT_TRUE(stats, !tracker.query(0, 2 * B).isTransparent());
+
+    tracker.didDraw(0, B, GBlendMode::kSrcIn, false);
+    EXPECT_TRUE(stats, tracker.query(0, 2 * B).fKind == GDstState::kUnknown);
+
+    // rows outside the bitmap are ignored
+    tracker.clear(0);
+    tracker.didDraw(-100, -1, GBlendMode::kSrc, false);
+    tracker.didDraw(4 * B, 5 * B, GBlendMode::kSrc, false);
+    EXPECT_TRUE(stats, tracker.query(-10, 10 * B).isTransparent());
+
+    tracker.reset();
+    EXPECT_TRUE(stats, tracker.query(0, 1).fKind == GDstState::kUnknown);
+}
+
+static bool rows_equal(const GBitmap& bm, int top, int bottom, GPixel value) {
+    for (int y = top; y < bottom; ++y) {
+        for (int x = 0; x < bm.width(); ++x) {
+            if (*bm.getAddr(x, y) != value) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void test_deferred_clear(GTestStats* stats) {
+    const int B = GDeferredClear::kBandRows;
+    const int w = 20, h = 2 * B + 5, rowPixels = w + 3;   // padding after each row
+    const GPixel garbage = 0x12345678, red = 0xFFFF0000, blue = 0x800000FF;
+    std::vector<GPixel> storage(rowPixels * h, garbage);
+    GBitmap bm(w, h, rowPixels * 4, storage.data(), false);
+
+    GDeferredClear clear(bm);
+    EXPECT_FALSE(stats, clear.hasPending());
+    clear.clear(red);
+    clear.clear(blue);  // replaces the pending red
+    EXPECT_TRUE(stats, clear.hasPending());
+    EXPECT_TRUE(stats, rows_equal(bm, 0, h, garbage));
+
+    // only the band that is drawn into gets written
+    clear.willDraw(B + 1, B + 2);
+    EXPECT_TRUE(stats, rows_equal(bm, 0, B, garbage));
+    EXPECT_TRUE(stats, rows_equal(bm, B, 2 * B, blue));
+    EXPECT_TRUE(stats, rows_equal(bm, 2 * B, h, garbage));
+
+    clear.flush();
+    EXPECT_FALSE(stats, clear.hasPending());
+    EXPECT_TRUE(stats, rows_equal(bm, 0, h, blue));
+    bool paddingKept = true;
+    for (int y = 0; y < h; ++y) {
+        for (int x = w; x < rowPixels; ++x) {
+            paddingKept &= storage[y * rowPixels + x] == garbage;
+        }
+    }
+    EXPECT_TRUE(stats, paddingKept);
+
+    // big enough to be streamed
+    GBitmap big;
+    big.alloc(1024, 600);
+    GDeferredClear bigClear(big);
+    bigClear.clear(red);
+    bigClear.flush();
+    EXPECT_TRUE(stats, rows_equal(big, 0, big.height(), red));
+    free(big.pixels());
+
+    // unaligned start, odd count
+    GPixel pixels[40] = {};
+    GStreamFill(pixels + 1, 37, blue);
+    bool streamed = pixels[0] == 0 && pixels[38] == 0 && pixels[39] == 0;
+    for (int i = 1; i < 38; ++i) {
+        streamed &= pixels[i] == blue;
+    }
+    EXPECT_TRUE(stats, streamed);
+}
+
+static void test_clip_stack(GTestStats* stats) {
+    const int w = 100, h = 80;
+    GClipStack clip(w, h);
+    EXPECT_TRUE(stats, clip.isRect() && clip.bounds().width() == w && clip.bounds().height() == h);
+
+    // device-aligned rects only shrink the bounds
+    clip.save();
+    clip.clipRect(GRect::LTRB(10, 20, 50, 60), GMatrix::Translate(5, 5));
+    clip.clipRect(GRect::LTRB(0, 0, 30, 30), GMatrix::Scale(2, 2));
+    EXPECT_TRUE(stats, clip.isRect());
+    EXPECT_EQ(stats, clip.bounds().left, 15);
+    EXPECT_EQ(stats, clip.bounds().top, 25);
+    EXPECT_EQ(stats, clip.bounds().right, 55);
+    EXPECT_EQ(stats, clip.bounds().bottom, 60);
+    clip.restore();
+    EXPECT_TRUE(stats, clip.isRect() && clip.bounds().right == w && clip.bounds().bottom == h);
+
+    // so do rects rotated by 90 degrees
+    clip.save();
+    clip.clipRect(GRect::LTRB(0, 0, 10, 20), GMatrix(0, -1, 50, 1, 0, 0));
+    EXPECT_TRUE(stats, clip.isRect());
+    EXPECT_EQ(stats, clip.bounds().left, 30);
+    EXPECT_EQ(stats, clip.bounds().bottom, 10);
+    clip.restore();
+
+    // anything else needs a mask
+    clip.save();
+    const GPoint tri[] = {{10, 10}, {90, 10}, {10, 70}};
+    GPathBuilder bu;
+    bu.addPolygon(tri, 3);
+    auto path = bu.detach();
+    clip.clipPath(*path, GMatrix());
+    EXPECT_FALSE(stats, clip.isRect());
+    EXPECT_TRUE(stats, clip.bounds().left == 10 && clip.bounds().top == 10);
+    EXPECT_TRUE(stats, clip.coverage(12, 12) == 0xFF);
+    EXPECT_TRUE(stats, clip.coverage(80, 60) == 0);
+
+    // draw the whole clip through its blitter: only the masked pixels change
+    GBitmap bm;
+    bm.alloc(w, h);
+    memset(bm.pixels(), 0, w * h * sizeof(GPixel));
+    GArena arena;
+    const GPixel red = GPixel_PackARGB(0xFF, 0xFF, 0, 0);
+    GOpaqueStoreBlitter store(bm, red);
+    const GIRect b = clip.bounds();
+    GBlitter* blitter = clip.clipBlitter(&store, &arena);
+    blitter->blitRect(b.left, b.top, b.width(), b.height());
+    bool masked = true;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const bool in = x >= b.left && x < b.right && y >= b.top && y < b.bottom &&
+                            clip.coverage(x, y);
+            masked &= *bm.getAddr(x, y) == (in ? red : 0);
+        }
+    }
+    EXPECT_TRUE(stats, masked);
+
+    // partial coverage is masked too
+    const GAlphaRun runs[] = {{(uint16_t)b.width(), 0x80}, {0, 0}};
+    blitter->blitAntiH(b.left, b.bottom - 1, runs);
+    EXPECT_EQ(stats, *bm.getAddr(b.right - 1, b.bottom - 1), 0u);
+    EXPECT_EQ(stats, GPixel_GetA(*bm.getAddr(b.left, b.bottom - 1)), 0xFF);
+
+    // a rect on top of a mask keeps the mask
+    clip.clipRect(GRect::LTRB(0, 0, 40, 40), GMatrix());
+    EXPECT_TRUE(stats, !clip.isRect() && clip.bounds().right == 40);
+    clip.restore();
+    EXPECT_TRUE(stats, clip.isRect());
+
+    clip.clipRect(GRect::LTRB(200, 200, 300, 300), GMatrix());
+    EXPECT_TRUE(stats, clip.isEmpty());
+    free(bm.pixels());
+
+    // masks are reused once no state has them, without changing the ones still saved
+    GClipStack reused(w, h), fresh(w, h);
+    reused.save();
+    reused.clipPath(*path, GMatrix::Rotate(0.2f));
+    reused.restore();
+    reused.clipPath(*path, GMatrix());
+    reused.save();
+    reused.clipPath(*path, GMatrix::Translate(5, -3));
+    reused.restore();
+    fresh.clipPath(*path, GMatrix());
+    bool sameMask = reused.bounds() == fresh.bounds() && !reused.isRect();
+    for (int y = fresh.bounds().top; y < fresh.bounds().bottom && sameMask; ++y) {
+        for (int x = fresh.bounds().left; x < fresh.bounds().right; ++x) {
+            sameMask &= reused.coverage(x, y) == fresh.coverage(x, y);
+        }
+    }
+    EXPECT_TRUE(stats, sameMask);
+
+    // a vertex far outside keeps the slope of its edges (at row 10, x = 573.7)
+    GClipStack far(1000, 500);
+    const GPoint wide[] = {{50, 0}, {20000, 400}, {50, 400}};
+    bu.addPolygon(wide, 3);
+    far.clipPath(*bu.detach(), GMatrix());
+    EXPECT_TRUE(stats, far.coverage(573, 10) == 0xFF);
+    EXPECT_TRUE(stats, far.coverage(574, 10) == 0);
+    EXPECT_TRUE(stats, far.coverage(999, 399) == 0xFF);
+}
+
+static void test_canvas_clip(GTestStats* stats) {
+    const int w = 60, h = 60;
+    const GPaint red({1, 0, 0, 1}), blue({0, 0, 1, 1});
+    GBitmap bm;
+    bm.alloc(w, h);
+    auto canvas = GCreateCanvas(bm);
+    canvas->clear({0, 0, 0, 0});
+
+    // the clip is mapped by the CTM, and restored with it
+    canvas->save();
+    canvas->translate(10, 10);
+    canvas->clipRect(GRect::WH(20, 20));
+    canvas->drawRect(GRect::LTRB(-100, -100, 100, 100), red);
+    canvas->restore();
+    canvas->drawRect(GRect::WH(5, 5), blue);
+    canvas->flush();
+    EXPECT_EQ(stats, *bm.getAddr(15, 15), 0xFFFF0000);
+    EXPECT_EQ(stats, *bm.getAddr(9, 15), 0u);
+    EXPECT_EQ(stats, *bm.getAddr(30, 29), 0u);
+    EXPECT_EQ(stats, *bm.getAddr(2, 2), 0xFF0000FF);
+
+    // filling a path clip looks just like drawing the path
+    GPathBuilder bu;
+    const GPoint star[] = {{30, 2}, {48, 56}, {2, 22}, {58, 22}, {12, 56}};
+    bu.addPolygon(star, GARRAY_COUNT(star));
+    auto path = bu.detach();
+
+    GBitmap ref;
+    ref.alloc(w, h);
+    auto refCanvas = GCreateCanvas(ref);
+    refCanvas->clear({0, 0, 0, 0});
+    refCanvas->drawPath(*path, red);
+    refCanvas->flush();
+
+    canvas->clear({0, 0, 0, 0});
+    canvas->save();
+    canvas->clipPath(*path);
+    canvas->drawRect(GRect::WH(w, h), red);
+    canvas->restore();
+    canvas->flush();
+    EXPECT_TRUE(stats, same_pixels(bm, ref));
+
+    // and so does the recorded version
+    GRecordingCanvas recorder;
+    recorder.clear({0, 0, 0, 0});
+    recorder.clipPath(*path);
+    recorder.drawRect(GRect::WH(w, h), red);
+    auto list = recorder.finishRecording();
+    EXPECT_TRUE(stats, list->op(1) == GDisplayList::Op::kClipPath);
+    list->playback(canvas.get());
+    canvas->flush();
+    EXPECT_TRUE(stats, same_pixels(bm, ref));
+    canvas->drawRect(GRect::WH(5, 5), blue);   // the clip did not leak out of playback
+    canvas->flush();
+    EXPECT_EQ(stats, *bm.getAddr(2, 2), 0xFF0000FF);
+
+    // clear() ignores the clip
+    canvas->save();
+    canvas->clipRect(GRect::LTRB(10, 10, 20, 20));
+    canvas->clipPath(*path);
+    canvas->clear({0, 0, 1, 1});
+    canvas->restore();
+    canvas->flush();
+    bool cleared = true;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            cleared &= *bm.getAddr(x, y) == 0xFF0000FF;
+        }
+    }
+    EXPECT_TRUE(stats, cleared);
+
+    free(bm.pixels());
+    free(ref.pixels());
+}
+
+namespace {
+// Only implements what a canvas had to before clipping, and counts the clips it is given
+class UnclippedCanvas : public GCanvas {
+public:
+    int fClipPaths = 0;
+
+    void save() override {}
+    void restore() override {}
+    void concat(const GMatrix&) override {}
+    void clear(const GColor&) override {}
+    void drawRect(const GRect&, const GPaint&) override {}
+    void drawConvexPolygon(const GPoint[], int, const GPaint&) override {}
+    void drawPath(const GPath& path, const GPaint&) override {}
+};
+
+class PathClipCanvas : public UnclippedCanvas {
+public:
+    GRect fBounds = GRect::WH(0, 0);
+
+    void clipPath(const GPath& path) override {
+        fClipPaths += 1;
+        fBounds = path.bounds();
+    }
+};
+}  // namespace
+
+static void test_canvas_clip_defaults(GTestStats* stats) {
+    // canvases that predate clipping still compile, and ignore it
+    UnclippedCanvas old;
+    old.clipRect(GRect::WH(10, 10));
+    EXPECT_EQ(stats, old.fClipPaths, 0);
+
+    // clipRect() defaults to clipPath() with the rect
+    PathClipCanvas canvas;
+    canvas.clipRect(GRect::LTRB(1, 2, 30, 40));
+    EXPECT_EQ(stats, canvas.fClipPaths, 1);
+    EXPECT_TRUE(stats, canvas.fBounds.left == 1 && canvas.fBounds.top == 2 &&
+                       canvas.fBounds.right == 30 && canvas.fBounds.bottom == 40);
+}
+
+static bool same_irect(const GIRect& a, const GIRect& b) {
+    return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+static void test_dirty_rect(GTestStats* stats) {
+    GDirtyRect dirty(100, 50);
+    EXPECT_TRUE(stats, dirty.isEmpty());
+    EXPECT_TRUE(stats, dirty.take().isEmpty());
+
+    // joined, and limited to the bitmap
+    dirty.join(GIRect::LTRB(10, 20, 30, 40));
+    dirty.join(GIRect::LTRB(-5, 30, 20, 80));
+    dirty.join(GIRect::LTRB(200, 0, 300, 10));  // outside, so ignored
+    EXPECT_TRUE(stats, same_irect(dirty.take(), GIRect::LTRB(0, 20, 30, 50)));
+    EXPECT_TRUE(stats, dirty.isEmpty());
+
+    dirty.join(GIRect::LTRB(1, 2, 3, 4));
+    dirty.joinAll();
+    EXPECT_TRUE(stats, same_irect(dirty.take(), GIRect::WH(100, 50)));
+
+    // a canvas that tracks its changes must report every pixel it changed
+    const int w = 64, h = 48;
+    GBitmap bm, before;
+    bm.alloc(w, h);
+    before.alloc(w, h);
+    auto canvas = GCreateCanvas(bm);
+    canvas->clear({1, 1, 1, 1});
+    canvas->flush();
+    GIRect r;
+    if (!canvas->takeDirtyRect(&r)) {
+        free(bm.pixels());
+        free(before.pixels());
+        return;
+    }
+    EXPECT_TRUE(stats, same_irect(r, GIRect::WH(w, h)));
+    EXPECT_TRUE(stats, canvas->takeDirtyRect(&r) && r.isEmpty());
+
+    memcpy(before.pixels(), bm.pixels(), w * h * sizeof(GPixel));
+    canvas->save();
+    canvas->clipRect(GRect::LTRB(8, 8, 40, 30));
+    canvas->drawRect(GRect::LTRB(20.5f, -10, 100, 20.25f), GPaint({1, 0, 0, 1}));
+    canvas->restore();
+    canvas->flush();
+    EXPECT_TRUE(stats, canvas->takeDirtyRect(&r));
+    bool covered = r.left >= 8 && r.top >= 8 && r.right <= 40 && r.bottom <= 30;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const bool in = x >= r.left && x < r.right && y >= r.top && y < r.bottom;
+            covered &= in || *bm.getAddr(x, y) == *before.getAddr(x, y);
+        }
+    }
+    EXPECT_TRUE(stats, covered);
+
+    free(bm.pixels());
+    free(before.pixels());
+}
+
+static void test_quick_reject(GTestStats* stats) {
+    const GIRect clip = GIRect::LTRB(10, 10, 50, 40);
+    const GMatrix I;
+    GQuickReject_ResetCounts();
+
+    EXPECT_FALSE(stats, GQuickReject(GRect::LTRB(0, 0, 100, 100), I, clip));
+    EXPECT_FALSE(stats, GQuickReject(GRect::LTRB(49, 39, 60, 60), I, clip));
+    EXPECT_FALSE(stats, GQuickReject(GRect::LTRB(9.5f, 0, 10.5f, 100), I, clip));
+    // ending exactly on the edge of the clip touches nothing, even antialiased
+    EXPECT_TRUE(stats, GQuickReject(GRect::LTRB(0, 0, 10, 100), I, clip));
+    EXPECT_TRUE(stats, GQuickReject(GRect::LTRB(50, 0, 60, 100), I, clip));
+    EXPECT_TRUE(stats, GQuickReject(GRect::LTRB(0, 40, 100, 60), I, clip));
+    EXPECT_TRUE(stats, GQuickReject(GRect::LTRB(0, -20, 100, 10), I, clip));
+    EXPECT_TRUE(stats, GQuickReject(GRect::LTRB(20, 20, 30, 30), I, GIRect::LTRB(0, 0, 0, 0)));
+    EXPECT_TRUE(stats, GQuickReject(GRect::LTRB(20, 20, 20, 30), I, clip));
+
+    // bounds are mapped by the ctm
+    EXPECT_TRUE(stats, GQuickReject(GRect::LTRB(20, 20, 30, 30), GMatrix::Translate(100, 0), clip));
+    EXPECT_FALSE(stats, GQuickReject(GRect::LTRB(-5, -5, 5, 5),
+                                     GMatrix::Translate(30, 25) * GMatrix::Rotate(0.7f), clip));
+    EXPECT_TRUE(stats, GQuickReject(GRect::LTRB(20, 20, 30, 30), GMatrix::Scale(-1, 1), clip));
+
+    // not finite is never rejected
+    const float inf = std::numeric_limits<float>::infinity();
+    EXPECT_FALSE(stats, GQuickReject(GRect::LTRB(100, 100, inf, inf), GMatrix::Scale(0, 0), clip));
+
+    EXPECT_EQ(stats, GQuickReject_RejectCount(), 8);
+    EXPECT_EQ(stats, GQuickReject_AcceptCount(), 5);
+    GQuickReject_ResetCounts();
+    EXPECT_EQ(stats, GQuickReject_RejectCount() + GQuickReject_AcceptCount(), 0);
+
+    // whatever a canvas rejects, it does not draw
+    const int w = 40, h = 30;
+    GBitmap bm;
+    bm.alloc(w, h);
+    auto canvas = GCreateCanvas(bm);
+    canvas->clear({0, 0, 0, 0});
+    canvas->clipRect(GRect::LTRB(5, 5, 35, 25));
+    const GRect rects[] = {
+        GRect::LTRB(-30, -30, 5, 100), GRect::LTRB(35, 0, 80, 30), GRect::LTRB(0, 25, 40, 90),
+        GRect::LTRB(4.6f, 4.6f, 5.4f, 5.4f), GRect::LTRB(10, 10, 20, 20),
+    };
+    bool untouched = true;
+    for (const GRect& r : rects) {
+        if (canvas->quickReject(r)) {
+            const GPoint quad[] = {{r.left, r.top}, {r.right, r.top}, {r.right, r.bottom},
+                                   {r.left, r.bottom}};
+            canvas->drawRect(r, GPaint({1, 0, 0, 1}));
+            canvas->drawConvexPolygon(quad, 4, GPaint());
+        }
+    }
+    canvas->flush();
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            untouched &= *bm.getAddr(x, y) == 0;
+        }
+    }
+    EXPECT_TRUE(stats, untouched);
+    EXPECT_FALSE(stats, canvas->quickReject(GRect::LTRB(10, 10, 20, 20)));
+    free(bm.pixels());
+}
+
+static std::shared_ptr<GPath> make_poly(const GPoint pts[], int count) {
+    GPathBuilder bu;
+    bu.moveTo(pts[0]);
+    for (int i = 1; i < count; ++i) {
+        bu.lineTo(pts[i]);
+    }
+    return bu.detach();
+}
+
+static void test_path_convexity(GTestStats* stats) {
+    const GPoint square[] = {{0, 0}, {10, 0}, {10, 10}, {0, 10}};
+    const GPoint backwards[] = {{0, 0}, {0, 10}, {10, 10}, {10, 0}};
+    const GPoint triangle[] = {{5, 0}, {10, 8}, {0, 8}};
+    const GPoint collinear[] = {{0, 0}, {5, 0}, {10, 0}, {10, 10}, {10, 10}, {0, 10}};
+    const GPoint line[] = {{0, 0}, {5, 5}, {10, 10}};
+    const GPoint ell[] = {{0, 0}, {10, 0}, {10, 5}, {5, 5}, {5, 10}, {0, 10}};
+    const GPoint star[] = {{30, 2}, {48, 56}, {2, 22}, {58, 22}, {12, 56}};
+    const GPoint spike[] = {{0, 0}, {10, 0}, {10, 10}, {10, 5}};
+    const GPoint twice[] = {{0, 0}, {10, 0}, {10, 10}, {0, 10}, {0, 0}, {10, 0}, {10, 10},
+                            {0, 10}};
+
+    EXPECT_TRUE(stats, make_poly(square, 4)->isConvex());
+    EXPECT_TRUE(stats, make_poly(backwards, 4)->isConvex());
+    EXPECT_TRUE(stats, make_poly(triangle, 3)->isConvex());
+    EXPECT_TRUE(stats, make_poly(collinear, 6)->isConvex());
+    EXPECT_TRUE(stats, make_poly(line, 3)->isConvex());
+    EXPECT_FALSE(stats, make_poly(ell, 6)->isConvex());
+    EXPECT_FALSE(stats, make_poly(star, 5)->isConvex());
+    EXPECT_FALSE(stats, make_poly(spike, 4)->isConvex());
+    EXPECT_FALSE(stats, make_poly(twice, 8)->isConvex());
+
+    // a circle-ish polygon, with many points
+    std::vector<GPoint> circle;
+    for (int i = 0; i < 100; ++i) {
+        const float angle = i * 2 * 3.14159265f / 100;
+        circle.push_back({50 + 40 * cosf(angle), 50 + 40 * sinf(angle)});
+    }
+    EXPECT_TRUE(stats, make_poly(circle.data(), (int)circle.size())->isConvex());
+
+    // more than one contour is never convex
+    GPathBuilder bu;
+    bu.moveTo(0, 0); bu.lineTo(10, 0); bu.lineTo(0, 10);
+    bu.moveTo(20, 20); bu.lineTo(30, 20); bu.lineTo(20, 30);
+    EXPECT_FALSE(stats, bu.detach()->isConvex());
+    EXPECT_TRUE(stats, bu.detach()->isConvex());     // empty
+
+    // remembered, and kept by transform(), including mirroring
+    auto path = make_poly(ell, 6);
+    EXPECT_FALSE(stats, path->isConvex());
+    EXPECT_FALSE(stats, path->transform(GMatrix::Scale(-2, 3))->isConvex());
+    path = make_poly(triangle, 3);
+    EXPECT_TRUE(stats, path->transform(GMatrix::Rotate(1))->isConvex());
+    EXPECT_TRUE(stats, path->isConvex());
+    EXPECT_TRUE(stats, path->transform(GMatrix::Scale(-1, 1))->isConvex());
+}
+
+static bool same_rect(const GRect& a, const GRect& b) {
+    return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+static void test_axis_rect(GTestStats* stats) {
+    const GRect expected = GRect::LTRB(1, 2, 5, 7);
+    const GPoint cw[] = {{1, 2}, {5, 2}, {5, 7}, {1, 7}};
+    const GPoint ccw[] = {{5, 7}, {5, 2}, {1, 2}, {1, 7}};
+    const GPoint closed[] = {{1, 7}, {1, 2}, {1, 2}, {5, 2}, {5, 7}, {1, 7}, {1, 7}};
+    const GPoint skewed[] = {{1, 2}, {5, 2}, {6, 7}, {1, 7}};
+    const GPoint diamond[] = {{3, 0}, {6, 3}, {3, 6}, {0, 3}};
+    const GPoint bowtie[] = {{1, 2}, {5, 7}, {5, 2}, {1, 7}};
+    const GPoint extra[] = {{1, 2}, {3, 2}, {5, 2}, {5, 7}, {1, 7}};
+    const GPoint flat[] = {{1, 2}, {5, 2}, {5, 2}, {1, 2}};
+
+    GRect r;
+    EXPECT_TRUE(stats, GPolygonIsAxisRect(cw, 4, &r) && same_rect(r, expected));
+    EXPECT_TRUE(stats, GPolygonIsAxisRect(ccw, 4, &r) && same_rect(r, expected));
+    EXPECT_TRUE(stats, GPolygonIsAxisRect(closed, 7, &r) && same_rect(r, expected));
+    EXPECT_FALSE(stats, GPolygonIsAxisRect(skewed, 4, &r));
+    EXPECT_FALSE(stats, GPolygonIsAxisRect(diamond, 4, &r));
+    EXPECT_FALSE(stats, GPolygonIsAxisRect(bowtie, 4, &r));
+    EXPECT_FALSE(stats, GPolygonIsAxisRect(extra, 5, &r));
+    EXPECT_FALSE(stats, GPolygonIsAxisRect(flat, 4, &r));
+    EXPECT_FALSE(stats, GPolygonIsAxisRect(cw, 3, &r));
+
+    // paths are rects after any CTM that keeps them axis-aligned
+    auto path = make_poly(cw, 4);
+    EXPECT_TRUE(stats, path->isRect(&r) && same_rect(r, expected));
+    const GMatrix rotate90(0, -1, 0, 1, 0, 0);
+    EXPECT_TRUE(stats, path->transform(rotate90)->isRect(&r) &&
+                       same_rect(r, GRect::LTRB(-7, 1, -2, 5)));
+    EXPECT_FALSE(stats, path->transform(GMatrix::Rotate(0.3f))->isRect(&r));
+    GPathBuilder bu;
+    bu.addPolygon(cw, 4);
+    bu.addPolygon(cw, 4);
+    EXPECT_FALSE(stats, bu.detach()->isRect(&r));
+    // every point is a corner, but the last one starts a (second, empty) contour
+    bu.addPolygon(cw, 3);
+    bu.moveTo(cw[3]);
+    EXPECT_FALSE(stats, bu.detach()->isRect(&r));
+
+    // the rect fill has the same pixels as the polygon fill
+    const int w = 40, h = 30;
+    GBitmap a, b;
+    a.alloc(w, h);
+    b.alloc(w, h);
+    auto ca = GCreateCanvas(a), cb = GCreateCanvas(b);
+    const GPoint quad[] = {{30.5f, 3.2f}, {30.5f, 24.5f}, {2.4f, 24.5f}, {2.4f, 3.2f}};
+    const GPaint paint({0.5f, 0, 0.5f, 0.5f});
+    bool same = true;
+    for (int i = 0; i < 2; ++i) {
+        ca->clear({1, 1, 1, 1});
+        cb->clear({1, 1, 1, 1});
+        ca->drawConvexPolygon(quad, 4, paint);
+        cb->drawRect(GRect::LTRB(2.4f, 3.2f, 30.5f, 24.5f), paint);
+        ca->flush();
+        cb->flush();
+        same &= same_pixels(a, b);
+        ca->scale(-1, 1);       // mirrored: still a rect
+        ca->translate(-w, 0);
+        cb->scale(-1, 1);
+        cb->translate(-w, 0);
+    }
+    EXPECT_TRUE(stats, same);
+    free(a.pixels());
+    free(b.pixels());
+}
+
+static void test_edge(GTestStats* stats) {
+    GEdge edge[GEdge::kMaxPerLine];
+    EXPECT_EQ(stats, GEdge::SetLine({0, 5}, {100, 5}, edge), 0);        // horizontal
+    EXPECT_EQ(stats, GEdge::SetLine({0, 5.6f}, {10, 6.4f}, edge), 0);   // misses row 5 and 6
+
+    // rows whose centers are in [top, bottom)
+    EXPECT_EQ(stats, GEdge::SetLine({0, 2.5f}, {0, 4.5f}, edge), 1);
+    EXPECT_TRUE(stats, edge[0].fTop == 2 && edge[0].fBottom == 4 && edge[0].fWinding == 1);
+    EXPECT_EQ(stats, GEdge::SetLine({0, 4.6f}, {0, 2.4f}, edge), 1);
+    EXPECT_TRUE(stats, edge[0].fTop == 2 && edge[0].fBottom == 5 && edge[0].fWinding == -1);
+
+    // walking the edge gives the same x as evaluating it at each center
+    GRandom rand;
+    bool matches = true;
+    int edges = 0;
+    GEdge_ResetCounts();
+    for (int i = 0; i < 1000; ++i) {
+        const GPoint p0 = {rand.nextF() * 500 - 100, rand.nextF() * 500 - 100},
+                     p1 = {rand.nextF() * 500 - 100, rand.nextF() * 500 - 100};
+        if (GEdge::SetLine(p0, p1, edge) == 0) {
+            continue;
+        }
+        edges += 1;
+        const GPoint a = p0.y < p1.y ? p0 : p1,
+                     b = p0.y < p1.y ? p1 : p0;
+        for (int y = edge[0].fTop; y < edge[0].fBottom; ++y) {
+            const float x = a.x + (b.x - a.x) * (y + 0.5f - a.y) / (b.y - a.y);
+            matches &= std::abs(GFixedRoundToInt(edge[0].fX) - GRoundToInt(x)) <= 1;
+            matches &= std::abs(edge[0].fX - GFloatToFixed(x)) < GFixed1 / 64;
+            edge[0].fX += edge[0].fDX;
+        }
+    }
+    EXPECT_TRUE(stats, matches);
+    EXPECT_EQ(stats, GEdge_Count(), edges);
+
+    // steeper than kMaxCoord, across 2 rows: the slope is not pinned
+    EXPECT_EQ(stats, GEdge::SetLine({-8000, 0.4f}, {8000, 1.6f}, edge), 1);
+    EXPECT_TRUE(stats, edge[0].fTop == 0 && edge[0].fBottom == 2);
+    EXPECT_EQ(stats, GFixedRoundToInt(edge[0].fX), -6667);
+    EXPECT_EQ(stats, GFixedRoundToInt(edge[0].fX + edge[0].fDX), 6667);
+
+    // past the right, the line becomes vertical at kMaxCoord, from where it crosses it
+    EXPECT_EQ(stats, GEdge::SetLine({50, 0}, {20050, 400}, edge), 2);
+    EXPECT_TRUE(stats, edge[0].fTop == 0 && edge[0].fBottom == 163 && edge[1].fTop == 163 &&
+                       edge[1].fBottom == 400 && edge[1].fX == GEdge::kMaxCoord * GFixed1 &&
+                       edge[1].fDX == 0);
+    EXPECT_EQ(stats, GFixedRoundToInt(edge[0].fX + 10 * edge[0].fDX), 575);
+    // with both ends far away, the middle can be too short to cross a row center
+    EXPECT_EQ(stats, GEdge::SetLine({-1e30f, 0}, {1e30f, 10}, edge), 2);
+    EXPECT_TRUE(stats, edge[0].fX == -GEdge::kMaxCoord * GFixed1 && edge[0].fBottom == 5 &&
+                       edge[1].fX == GEdge::kMaxCoord * GFixed1 && edge[1].fTop == 5 &&
+                       edge[1].fBottom == 10);
+    // rows past kMaxCoord are dropped
+    EXPECT_EQ(stats, GEdge::SetLine({0, -1e9f}, {1, 1e9f}, edge), 1);
+    EXPECT_TRUE(stats, edge[0].fTop == -GEdge::kMaxCoord && edge[0].fBottom == GEdge::kMaxCoord);
+    EXPECT_EQ(stats, GEdge::SetLine({0, 0.49f}, {1e6f, 0.5001f}, edge), 1);
+    EXPECT_TRUE(stats, edge[0].fTop == 0 && edge[0].fBottom == 1);
+}
+
+// One "draw": edges for a path of n points, a span buffer, and a shader row
+static void fake_draw(GArena* arena, int n, int width) {
+    GEdge* edges = arena->makeArray<GEdge>(n);
+    GAlphaRun* runs = arena->makeArray<GAlphaRun>(width + 1);
+    GPixel* row = arena->makeArray<GPixel>(width);
+    edges[n - 1].fTop = 0;
+    runs[width].fCount = 0;
+    row[width - 1] = 0;
+}
+
+static void test_arena_reuse(GTestStats* stats) {
+    GArena arena(256);
+    const int sizes[] = {10, 400, 37, 1000, 3};
+    for (int n : sizes) {
+        fake_draw(&arena, n, 640);
+        arena.reset();
+    }
+    // once it has seen the biggest draw, the arena stops growing
+    const size_t capacity = arena.capacity();
+    bool stable = true;
+    for (int i = 0; i < 10; ++i) {
+        for (int n : sizes) {
+            fake_draw(&arena, n, 640);
+            arena.reset();
+            stable &= arena.capacity() == capacity;
+        }
+    }
+    EXPECT_TRUE(stats, stable);
+
+    // objects with destructors are destroyed by reset()
+    auto counter = std::make_shared<int>(0);
+    arena.make<std::shared_ptr<int>>(counter);
+    EXPECT_EQ(stats, (int)counter.use_count(), 2);
+    arena.reset();
+    EXPECT_EQ(stats, (int)counter.use_count(), 1);
+}
+
+static void test_batch_draws(GTestStats* stats) {
+    GRandom rand;
+    const int N = 40;
+    GRect rects[N];
+    GPaint paints[N];
+    GPoint quads[N * 4];
+    int counts[N];
+    std::shared_ptr<GPath> pathRefs[N];
+    const GPath* paths[N];
+    const GBlendMode modes[] = {GBlendMode::kSrcOver, GBlendMode::kXor, GBlendMode::kDstOut};
+    for (int i = 0; i < N; ++i) {
+        const float x = rand.nextF() * 60, y = rand.nextF() * 40;
+        rects[i] = GRect::XYWH(x, y, 5 + rand.nextF() * 30, 5 + rand.nextF() * 30);
+        paints[i] = GPaint({rand.nextF(), rand.nextF(), rand.nextF(), rand.nextF()});
+        paints[i].setBlendMode(modes[i % 3]);
+        counts[i] = 3 + (i & 1);    // triangles and quads
+        GPoint* q = &quads[i * 4];
+        q[0] = {x, y};
+        q[1] = {x + 20, y + 5};
+        q[2] = {x + 10, y + 25};
+        q[3] = {x - 2, y + 12};
+        GPathBuilder bu;
+        bu.addPolygon(q, counts[i]);
+        bu.addRect(GRect::XYWH(x + 3, y + 3, 10, 10));
+        pathRefs[i] = bu.detach();
+        paths[i] = pathRefs[i].get();
+    }
+
+    // the default versions record the same calls, in order
+    GRecordingCanvas recorder;
+    recorder.drawRects(rects, paints, N);
+    recorder.drawConvexPolygons(quads, counts, paints, N);
+    recorder.drawPaths(paths, paints, N);
+    auto list = recorder.finishRecording();
+    EXPECT_EQ(stats, list->count(), 3 * N);
+    EXPECT_TRUE(stats, list->op(N - 1) == GDisplayList::Op::kDrawRect &&
+                       list->op(N) == GDisplayList::Op::kDrawConvexPolygon &&
+                       list->op(3 * N - 1) == GDisplayList::Op::kDrawPath);
+
+    // and draw the same pixels as the single draws
+    const int w = 100, h = 80;
+    GBitmap single, batch;
+    single.alloc(w, h);
+    batch.alloc(w, h);
+    auto singleCanvas = GCreateCanvas(single), batchCanvas = GCreateCanvas(batch);
+    singleCanvas->clear({1, 1, 1, 1});
+    batchCanvas->clear({1, 1, 1, 1});
+    singleCanvas->rotate(0.1f);
+    batchCanvas->rotate(0.1f);
+    for (int i = 0; i < N; ++i) {
+        singleCanvas->drawRect(rects[i], paints[i]);
+    }
+    int start = 0;
+    for (int i = 0; i < N; ++i) {
+        singleCanvas->drawConvexPolygon(&quads[start], counts[i], paints[i]);
+        start += counts[i];
+    }
+    for (int i = 0; i < N; ++i) {
+        singleCanvas->drawPath(*paths[i], paints[i]);
+    }
+    batchCanvas->drawRects(rects, paints, N);
+    batchCanvas->drawConvexPolygons(quads, counts, paints, N);
+    batchCanvas->drawPaths(paths, paints, N);
+    singleCanvas->flush();
+    batchCanvas->flush();
+    EXPECT_TRUE(stats, same_pixels(single, batch));
+
+    free(single.pixels());
+    free(batch.pixels());
+}
+
+static bool same_edges(const GEdge a[], const GEdge b[], int count) {
+    bool same = true;
+    for (int i = 0; i < count; ++i) {
+        same &= a[i].fTop == b[i].fTop && a[i].fBottom == b[i].fBottom && a[i].fX == b[i].fX &&
+                a[i].fDX == b[i].fDX && a[i].fWinding == b[i].fWinding;
+    }
+    return same;
+}
+
+static void test_path_instances(GTestStats* stats) {
+    const GPoint star[] = {{30, 2}, {48, 56}, {2, 22}, {58, 22}, {12, 56}};
+    GPathBuilder bu;
+    bu.addPolygon(star, GARRAY_COUNT(star));
+    bu.moveTo(0, 0);
+    bu.lineTo(10, 0);
+    bu.lineTo(5, 8);
+    auto path = bu.detach();
+
+    // edges are built once, and can then be offset by whole pixels, exactly
+    const GMatrix ctm = GMatrix::Translate(3.25f, 7.5f) * GMatrix::Rotate(0.3f) *
+                        GMatrix::Scale(1.5f, 0.75f);
+    std::vector<GEdge> edges(GMaxEdgeCount(*path)), moved(GMaxEdgeCount(*path));
+    EXPECT_EQ(stats, GBuildEdges(*path, GMatrix(), edges.data()), 6);  // 2 are horizontal
+    const int count = GBuildEdges(*path, ctm, edges.data());
+    EXPECT_EQ(stats, count, 8);     // rotated, nothing is horizontal
+    GOffsetEdges(edges.data(), count, 17, -4);
+    EXPECT_EQ(stats, GBuildEdges(*path, GMatrix::Translate(17, -4) * ctm, moved.data()), count);
+    EXPECT_TRUE(stats, same_edges(edges.data(), moved.data(), count));
+
+    // the default drawPathInstances() is a drawPath() per instance
+    const int n = 6;
+    GMatrix matrices[n];
+    GPaint paints[n];
+    for (int i = 0; i < n; ++i) {
+        matrices[i] = GMatrix::Translate(i * 9.0f, i * 3.0f) * GMatrix::Rotate(i * 0.2f);
+        paints[i] = GPaint({i / 6.0f, 0.5f, 1 - i / 6.0f, 0.75f});
+        paints[i].setBlendMode(i & 1 ? GBlendMode::kSrcOver : GBlendMode::kXor);
+    }
+    GRecordingCanvas recorder;
+    recorder.drawPathInstances(*path, matrices, paints, n);
+    auto list = recorder.finishRecording();
+    EXPECT_EQ(stats, list->count(), 4 * n);
+    EXPECT_TRUE(stats, list->op(2) == GDisplayList::Op::kDrawPath);
+
+    const int w = 120, h = 100;
+    GBitmap a, b;
+    a.alloc(w, h);
+    b.alloc(w, h);
+    auto ca = GCreateCanvas(a), cb = GCreateCanvas(b);
+    ca->clear({1, 1, 1, 1});
+    cb->clear({1, 1, 1, 1});
+    ca->translate(10, 5);
+    cb->translate(10, 5);
+    for (int i = 0; i < n; ++i) {
+        ca->save();
+        ca->concat(matrices[i]);
+        ca->drawPath(*path, paints[i]);
+        ca->restore();
+    }
+    cb->drawPathInstances(*path, matrices, paints, n);
+    ca->drawRect(GRect::WH(4, 4), GPaint({0, 0, 0, 1}));   // the CTM is back where it was
+    cb->drawRect(GRect::WH(4, 4), GPaint({0, 0, 0, 1}));
+    ca->flush();
+    cb->flush();
+    EXPECT_TRUE(stats, same_pixels(a, b));
+    free(a.pixels());
+    free(b.pixels());
+}
+
+static void test_edge_cache(GTestStats* stats) {
+    const GPoint star[] = {{30, 2}, {48, 56}, {2, 22}, {58, 22}, {12, 56}};
+    GPathBuilder bu;
+    bu.addPolygon(star, GARRAY_COUNT(star));
+    auto path = bu.detach();
+    auto copy = std::make_shared<GPath>(*path);
+    auto moved = path->offset(1, 0);
+    EXPECT_TRUE(stats, path->uniqueID() != 0);
+    EXPECT_TRUE(stats, copy->uniqueID() == path->uniqueID());
+    EXPECT_TRUE(stats, moved->uniqueID() != path->uniqueID());
+
+    const GMatrix ctm = GMatrix::Translate(3.25f, 7.5f) * GMatrix::Rotate(0.3f);
+    const int n = GMaxEdgeCount(*path);
+    std::vector<GEdge> expected(n), edges(n);
+
+    // sorted by top, and only built the first time
+    GEdgeCache cache;
+    GEdge_ResetCounts();
+    const int count = cache.getEdges(*path, ctm, edges.data());
+    EXPECT_EQ(stats, count, GBuildEdges(*path, ctm, expected.data()));
+    EXPECT_EQ(stats, GEdge_Count(), 2 * count);
+    bool sorted = true;
+    for (int i = 1; i < count; ++i) {
+        sorted &= edges[i - 1].fTop <= edges[i].fTop;
+    }
+    EXPECT_TRUE(stats, sorted);
+    EXPECT_EQ(stats, cache.getEdges(*copy, ctm, edges.data()), count);
+    EXPECT_EQ(stats, GEdge_Count(), 2 * count);
+    EXPECT_EQ(stats, cache.hits(), 1);
+    EXPECT_EQ(stats, cache.misses(), 1);
+
+    // an integer translate is a hit (with the edges moved), anything else is not
+    std::sort(expected.begin(), expected.begin() + count, [](const GEdge& a, const GEdge& b) {
+        return a.fTop < b.fTop;
+    });
+    GOffsetEdges(expected.data(), count, -5, 12);
+    EXPECT_EQ(stats, cache.getEdges(*path, GMatrix::Translate(-5, 12) * ctm, edges.data()), count);
+    EXPECT_TRUE(stats, same_edges(edges.data(), expected.data(), count));
+    EXPECT_EQ(stats, cache.offsetHits(), 1);
+
+    // a hit gives exactly the edges that a miss would have built
+    GRandom rand;
+    bool hitIsMiss = true;
+    for (int i = 0; i < 20; ++i) {
+        const GMatrix m = GMatrix::Translate((int)(rand.nextF() * 2000) - 1000,
+                                             (int)(rand.nextF() * 2000) - 1000) * ctm;
+        GEdgeCache fresh;
+        const int missCount = fresh.getEdges(*path, m, expected.data());
+        hitIsMiss &= cache.getEdges(*path, m, edges.data()) == missCount &&
+                     same_edges(edges.data(), expected.data(), missCount);
+    }
+    EXPECT_TRUE(stats, hitIsMiss);
+    EXPECT_EQ(stats, cache.misses(), 1);
+    // but not if it is out of range, where the edges are clipped
+    GEdgeCache far;
+    far.getEdges(*path, ctm, edges.data());
+    far.getEdges(*path, GMatrix::Translate(GEdge::kMaxCoord, 0) * ctm, edges.data());
+    EXPECT_EQ(stats, far.misses(), 2);
+    cache.getEdges(*path, GMatrix::Translate(0.5f, 0) * ctm, edges.data());
+    cache.getEdges(*moved, ctm, edges.data());
+    EXPECT_EQ(stats, cache.misses(), 3);
+
+    // the least recently used entry is replaced
+    std::vector<std::shared_ptr<GPath>> others;
+    for (int i = 0; i < GEdgeCache::kMaxEntries - 1; ++i) {
+        others.push_back(path->offset(0, i + 1.0f));
+        cache.getEdges(*others.back(), ctm, edges.data());
+    }
+    EXPECT_EQ(stats, cache.misses(), 3 + GEdgeCache::kMaxEntries - 1);
+    cache.getEdges(*moved, ctm, edges.data());    // used more recently than path, so kept
+    EXPECT_EQ(stats, cache.hits(), 3 + 20);
+    cache.getEdges(*path, ctm, edges.data());
+    EXPECT_EQ(stats, cache.misses(), 3 + GEdgeCache::kMaxEntries);
+
+    cache.reset();
+    cache.getEdges(*moved, ctm, edges.data());
+    EXPECT_EQ(stats, cache.misses(), 4 + GEdgeCache::kMaxEntries);
+}
+
+namespace {
+// Remembers the coverage of each pixel it is asked to blit
+class CoverageBlitter : public GBlitter {
+public:
+    enum { W = 32, H = 32 };
+    uint8_t fCoverage[H][W] = {};
+
+    void blitH(int x, int y, int width) override {
+        for (int i = 0; i < width; ++i) {
+            fCoverage[y][x + i] = 0xFF;
+        }
+    }
+    void blitAntiH(int x, int y, const GAlphaRun runs[]) override {
+        for (; runs->fCount; ++runs) {
+            for (int i = 0; i < runs->fCount; ++i, ++x) {
+                fCoverage[y][x] = std::max(fCoverage[y][x], runs->fAlpha);
+            }
+        }
+    }
+};
+
+// Some aliased and antialiased spans, for a mask or any other blitter
+void blit_spans(GBlitter* blitter) {
+    const GAlphaRun runs[] = {{2, 0}, {2, 0x80}, {3, 0xFF}, {1, 0x40}, {0, 0}};
+    blitter->blitH(2, 1, 3);
+    blitter->blitH(8, 1, 2);
+    blitter->blitAntiH(1, 3, runs);
+    blitter->blitH(5, 4, 1);
+    blitter->blitAntiH(8, 4, runs + 1);
+}
+}  // namespace
+
+static void test_scan_converter(GTestStats* stats) {
+    GScanConverter scan;
+    const GIRect all = GIRect::WH(CoverageBlitter::W, CoverageBlitter::H);
+
+    // the pixels whose centers are inside, one span per row
+    GPathBuilder bu;
+    bu.addRect(GRect::LTRB(1.4f, 2.5f, 5.4f, 4.5f));
+    CoverageBlitter rect;
+    scan.fillPath(*bu.detach(), GMatrix(), all, &rect);
+    bool inside = true;
+    for (int y = 0; y < CoverageBlitter::H; ++y) {
+        for (int x = 0; x < CoverageBlitter::W; ++x) {
+            const bool in = x >= 1 && x < 5 && y >= 2 && y < 4;
+            inside &= rect.fCoverage[y][x] == (in ? 0xFF : 0);
+        }
+    }
+    EXPECT_TRUE(stats, inside);
+
+    // the edges need not be sorted, and the spans stop at the clip
+    GEdge edges[3 * GEdge::kMaxPerLine];
+    int count = GEdge::SetLine({10, 4}, {10, 10}, edges);
+    count += GEdge::SetLine({20, 10}, {20, 0}, edges + count);
+    count += GEdge::SetLine({10, 0}, {10, 4}, edges + count);
+    CoverageBlitter clipped;
+    scan.fill(edges, count, GIRect::LTRB(12, 3, 40, 5), &clipped);
+    EXPECT_TRUE(stats, edges[0].fTop == 0 && edges[2].fTop == 4);
+    EXPECT_TRUE(stats, clipped.fCoverage[3][12] == 0xFF);
+    EXPECT_TRUE(stats, clipped.fCoverage[4][19] == 0xFF);
+    EXPECT_TRUE(stats, clipped.fCoverage[4][11] == 0);
+    EXPECT_TRUE(stats, clipped.fCoverage[5][15] == 0);
+    EXPECT_TRUE(stats, clipped.fCoverage[2][15] == 0);
+
+    // a clip covers the same pixels as drawing the path: a rotated star (winding 2 in the
+    // middle) next to a square with a hole cut out in the opposite direction
+    const GPoint star[] = {{16, 2}, {24, 28}, {3, 11}, {29, 11}, {8, 28}};
+    bu.addPolygon(star, GARRAY_COUNT(star));
+    bu.addRect(GRect::LTRB(22, 22, 30, 30));
+    bu.addRect(GRect::LTRB(24, 24, 28, 28), GPathDirection::kCCW);
+    const auto path = bu.detach();
+    const GMatrix ctm = GMatrix::Translate(16, 16) * GMatrix::Rotate(0.3f) *
+                        GMatrix::Translate(-16, -16);
+    CoverageBlitter drawn;
+    scan.fillPath(*path, ctm, all, &drawn);
+    GClipStack clip(CoverageBlitter::W, CoverageBlitter::H);
+    clip.clipPath(*path, ctm);
+    bool same = true;
+    for (int y = 0; y < CoverageBlitter::H; ++y) {
+        for (int x = 0; x < CoverageBlitter::W; ++x) {
+            const GIRect b = clip.bounds();
+            const bool in = x >= b.left && x < b.right && y >= b.top && y < b.bottom &&
+                            clip.coverage(x, y);
+            same &= drawn.fCoverage[y][x] == (in ? 0xFF : 0);
+        }
+    }
+    EXPECT_TRUE(stats, same);
+    EXPECT_TRUE(stats, drawn.fCoverage[16][16] == 0xFF);
+    EXPECT_TRUE(stats, drawn.fCoverage[30][16] == 0);
+    EXPECT_TRUE(stats, drawn.fCoverage[28][22] == 0);      // the hole
+}
+
+static bool near_coverage(uint8_t coverage, int alpha) {
+    return std::abs(coverage - alpha) <= 1;
+}
+
+static void test_scan_converter_aa(GTestStats* stats) {
+    GScanConverter scan;
+    const GIRect all = GIRect::WH(CoverageBlitter::W, CoverageBlitter::H);
+    GPathBuilder bu;
+
+    // the coverage is the area inside: halves, quarters, and 3/4 of a row
+    bu.addRect(GRect::LTRB(0.5f, 0, 2.5f, 1));
+    bu.addRect(GRect::LTRB(4.5f, 4.5f, 5.5f, 5.5f));
+    bu.addRect(GRect::LTRB(10, 10.25f, 11, 11));
+    CoverageBlitter rects;
+    scan.fillPathAntiAlias(*bu.detach(), GMatrix(), all, &rects);
+    EXPECT_TRUE(stats, near_coverage(rects.fCoverage[0][0], 128));
+    EXPECT_TRUE(stats, rects.fCoverage[0][1] == 0xFF);
+    EXPECT_TRUE(stats, near_coverage(rects.fCoverage[0][2], 128));
+    EXPECT_TRUE(stats, rects.fCoverage[0][3] == 0 && rects.fCoverage[1][1] == 0);
+    EXPECT_TRUE(stats, near_coverage(rects.fCoverage[4][4], 64) &&
+                       near_coverage(rects.fCoverage[4][5], 64) &&
+                       near_coverage(rects.fCoverage[5][4], 64) &&
+                       near_coverage(rects.fCoverage[5][5], 64));
+    EXPECT_TRUE(stats, near_coverage(rects.fCoverage[10][10], 191));
+
+    // a diagonal edge cuts the pixels it crosses in half
+    const GPoint tri[] = {{0, 8}, {4, 8}, {0, 12}};
+    bu.addPolygon(tri, 3);
+    CoverageBlitter diagonal;
+    scan.fillPathAntiAlias(*bu.detach(), GMatrix(), all, &diagonal);
+    bool halves = true;
+    for (int y = 8; y < 12; ++y) {
+        for (int x = 0; x < 5; ++x) {
+            const int d = x + y - 8;
+            halves &= near_coverage(diagonal.fCoverage[y][x], d < 3 ? 255 : d == 3 ? 128 : 0);
+        }
+    }
+    EXPECT_TRUE(stats, halves);
+
+    // a rotated square covers its area, however its edges cross the pixels
+    bu.addRect(GRect::LTRB(-3, -3, 3, 3));
+    const auto square = bu.detach();
+    const GMatrix ctm = GMatrix::Translate(20.3f, 19.6f) * GMatrix::Rotate(0.5f);
+    CoverageBlitter rotated;
+    scan.fillPathAntiAlias(*square, ctm, all, &rotated);
+    int sum = 0;
+    for (int y = 0; y < CoverageBlitter::H; ++y) {
+        for (int x = 0; x < CoverageBlitter::W; ++x) {
+            sum += rotated.fCoverage[y][x];
+        }
+    }
+    EXPECT_TRUE(stats, std::abs(sum - 36 * 255) < 255 / 4);
+
+    // clipping through the middle of its edges keeps the same coverage inside the clip
+    const GIRect clip = GIRect::LTRB(19, 18, 32, 21);
+    CoverageBlitter clipped;
+    scan.fillPathAntiAlias(*square, ctm, clip, &clipped);
+    bool same = true;
+    for (int y = 0; y < CoverageBlitter::H; ++y) {
+        for (int x = 0; x < CoverageBlitter::W; ++x) {
+            const bool inside = x >= clip.left && x < clip.right && y >= clip.top &&
+                                y < clip.bottom;
+            same &= std::abs(clipped.fCoverage[y][x] - (inside ? rotated.fCoverage[y][x] : 0))
+                    <= 1;
+        }
+    }
+    EXPECT_TRUE(stats, same);
+
+    // overlapping contours are covered once, and opposite ones cancel
+    bu.addRect(GRect::LTRB(0, 20, 4.5f, 21));
+    bu.addRect(GRect::LTRB(2, 20, 6, 21));
+    bu.addRect(GRect::LTRB(0, 24, 8, 25));
+    bu.addRect(GRect::LTRB(2, 24, 6.5f, 25), GPathDirection::kCCW);
+    CoverageBlitter winding;
+    scan.fillPathAntiAlias(*bu.detach(), GMatrix(), all, &winding);
+    EXPECT_TRUE(stats, winding.fCoverage[20][4] == 0xFF && winding.fCoverage[20][5] == 0xFF);
+    EXPECT_TRUE(stats, winding.fCoverage[24][1] == 0xFF && winding.fCoverage[24][3] == 0);
+    EXPECT_TRUE(stats, near_coverage(winding.fCoverage[24][6], 128));
+}
+
+static void test_mask_cache(GTestStats* stats) {
+    // a mask replays the spans it was built from, moved and clipped
+    GRLEMaskBuilder builder;
+    blit_spans(&builder);
+    const GRLEMask mask = builder.detach();
+    EXPECT_TRUE(stats, mask.bounds() == GIRect::LTRB(2, 1, 14, 5));
+    EXPECT_TRUE(stats, builder.detach().isEmpty());
+
+    CoverageBlitter direct, replayed, moved;
+    blit_spans(&direct);
+    mask.blit(&replayed, 0, 0, GIRect::WH(CoverageBlitter::W, CoverageBlitter::H));
+    const GIRect clip = GIRect::LTRB(6, 0, 16, 6);
+    mask.blit(&moved, 3, 1, clip);
+    bool same = true, sameMoved = true;
+    for (int y = 0; y < CoverageBlitter::H; ++y) {
+        for (int x = 0; x < CoverageBlitter::W; ++x) {
+            same &= replayed.fCoverage[y][x] == direct.fCoverage[y][x];
+            const bool inside = x >= clip.left && x < clip.right && y >= clip.top &&
+                                y < clip.bottom;
+            const uint8_t expected = inside && x >= 3 && y >= 1 ? direct.fCoverage[y - 1][x - 3]
+                                                                : 0;
+            sameMoved &= moved.fCoverage[y][x] == expected;
+        }
+    }
+    EXPECT_TRUE(stats, same);
+    EXPECT_TRUE(stats, sameMoved);
+
+    // the key is the path, the linear part of the ctm, and 1/4ths of its translate
+    GPathBuilder bu;
+    bu.addRect(GRect::LTRB(1, 1, 5, 4));
+    auto path = bu.detach();
+    GMaskCache_ResetCounts();
+    GMaskCache cache;
+    GMatrix rasterCTM;
+    int dx, dy;
+    EXPECT_TRUE(stats, !cache.find(*path, GMatrix::Translate(10.3f, 20.6f), false,
+                                   &rasterCTM, &dx, &dy));
+    // rasterized with the path's top left at the origin, then moved back by whole pixels
+    EXPECT_TRUE(stats, rasterCTM == GMatrix::Translate(0.25f - 1, 0.5f - 1));
+    EXPECT_TRUE(stats, dx == 10 + 1 && dy == 20 + 1);
+    GRLEMask copy = mask;
+    const GRLEMask* added = cache.add(*path, GMatrix::Translate(10.3f, 20.6f), false,
+                                      std::move(copy));
+    EXPECT_TRUE(stats, added && added->bounds() == mask.bounds());
+    EXPECT_TRUE(stats, cache.find(*path, GMatrix::Translate(13.4f, 18.7f), false,
+                                  &rasterCTM, &dx, &dy) == added);
+    EXPECT_TRUE(stats, dx == 13 + 1 && dy == 18 + 1);
+    EXPECT_TRUE(stats, cache.find(*std::make_shared<GPath>(*path), GMatrix::Translate(-2.7f, 0.5f),
+                                  false, &rasterCTM, &dx, &dy) == added);
+    EXPECT_TRUE(stats, dx == -3 + 1 && dy == 0 + 1);
+    EXPECT_TRUE(stats, !cache.find(*path, GMatrix::Translate(10.6f, 20.6f), false,
+                                   &rasterCTM, &dx, &dy));
+    EXPECT_TRUE(stats, !cache.find(*path, GMatrix::Translate(10.3f, 20.6f), true,
+                                   &rasterCTM, &dx, &dy));
+    EXPECT_TRUE(stats, !cache.find(*path, GMatrix::Scale(2, 2), false, &rasterCTM, &dx, &dy));
+    EXPECT_EQ(stats, cache.hits(), 2);
+    EXPECT_EQ(stats, cache.misses(), 4);
+    EXPECT_EQ(stats, GMaskCache_HitCount(), 2);
+    EXPECT_EQ(stats, GMaskCache_MissCount(), 4);
+    EXPECT_TRUE(stats, cache.bytesUsed() == mask.bytes());
+
+    // the least recently used masks are dropped to stay in the budget
+    GMaskCache small(mask.bytes() * 5 / 2);
+    std::shared_ptr<GPath> paths[3];
+    for (int i = 0; i < 3; ++i) {
+        paths[i] = path->offset(i + 1.0f, 0);
+        copy = mask;
+        small.add(*paths[i], GMatrix(), true, std::move(copy));
+    }
+    EXPECT_EQ(stats, small.count(), 2);
+    EXPECT_EQ(stats, small.evictions(), 1);
+    EXPECT_TRUE(stats, small.bytesUsed() <= small.budget());
+    EXPECT_TRUE(stats, !small.find(*paths[0], GMatrix(), true, &rasterCTM, &dx, &dy));
+    EXPECT_TRUE(stats, small.find(*paths[2], GMatrix(), true, &rasterCTM, &dx, &dy));
+
+    // too large to keep, but still returned
+    GMaskCache tiny(16);
+    copy = mask;
+    added = tiny.add(*path, GMatrix(), false, std::move(copy));
+    EXPECT_TRUE(stats, added && added->bounds() == mask.bounds());
+    EXPECT_EQ(stats, tiny.count(), 0);
+
+    // only paths inside the limit (e.g. the clip) are cached
+    const GIRect limit = GIRect::LTRB(0, 0, 100, 50);
+    EXPECT_TRUE(stats, GMaskCache::CanCache(*path, GMatrix::Translate(10, 20), limit));
+    EXPECT_FALSE(stats, GMaskCache::CanCache(*path, GMatrix::Translate(-2, 20), limit));
+    EXPECT_FALSE(stats, GMaskCache::CanCache(*path, GMatrix::Scale(100, 1), limit));
+    EXPECT_TRUE(stats, GMaskCache::QuantizeCTM(GMatrix::Translate(10.45f, -0.3f)) ==
+                       GMatrix::Translate(10.25f, -0.5f));
+
+    // a path far out in its own coordinates is still rasterized in range
+    bu.addRect(GRect::LTRB(10000, 10000, 10004, 10003));
+    auto far = bu.detach();
+    const GMatrix farCTM = GMatrix::Translate(-9990.25f, -9990);
+    EXPECT_TRUE(stats, GMaskCache::CanCache(*far, farCTM, limit));
+    EXPECT_TRUE(stats, !cache.find(*far, farCTM, false, &rasterCTM, &dx, &dy));
+    const GPoint corner = rasterCTM * GPoint{10000, 10000};
+    EXPECT_TRUE(stats, corner.x == 0.75f && corner.y == 0);
+    EXPECT_TRUE(stats, dx == 9 && dy == 10);
+
+    // so a canvas draws it just like the same path near the origin
+    bu.addRect(GRect::LTRB(0, 0, 4, 3));
+    auto near = bu.detach();
+    GBitmap a, b;
+    a.alloc(limit.width(), limit.height());
+    b.alloc(limit.width(), limit.height());
+    for (GBitmap* bm : {&a, &b}) {
+        auto canvas = GCreateCanvas(*bm);
+        canvas->clear({0, 0, 0, 0});
+        canvas->concat(bm == &a ? farCTM : GMatrix::Translate(9.75f, 10));
+        const GPath& p = bm == &a ? *far : *near;
+        canvas->drawPath(p, GPaint({1, 0, 0, 0.5f}));    // a miss, then (if cached) a hit
+        canvas->drawPath(p, GPaint({1, 0, 0, 0.5f}));
+        canvas->flush();
+    }
+    EXPECT_TRUE(stats, same_pixels(a, b));
+    EXPECT_TRUE(stats, GPixel_GetA(*b.getAddr(10, 11)) > 0x80);  // drawn twice
+
+    // a path that is drawn directly (here because it is not inside the clip) is drawn where
+    // its mask would be
+    const GPoint star[] = {{30, 2}, {48, 46}, {2, 22}, {58, 22}, {12, 46}};
+    bu.addPolygon(star, GARRAY_COUNT(star));
+    auto starPath = bu.detach();
+    for (GBitmap* bm : {&a, &b}) {
+        auto canvas = GCreateCanvas(*bm);
+        canvas->clear({0, 0, 0, 0});
+        canvas->clipRect(GRect::LTRB(0, 0, bm == &a ? 100 : 40, 50));
+        canvas->translate(10.45f, 0.7f);
+        canvas->rotate(0.05f);
+        canvas->drawPath(*starPath, GPaint({0, 0, 1, 1}));
+        canvas->flush();
+    }
+    bool sameInClip = true;
+    for (int y = 0; y < limit.height(); ++y) {
+        for (int x = 0; x < 40; ++x) {
+            sameInClip &= *a.getAddr(x, y) == *b.getAddr(x, y);
+        }
+    }
+    EXPECT_TRUE(stats, sameInClip);
+    free(a.pixels());
+    free(b.pixels());
+}
+
+static void test_parallel_rows(GTestStats* stats) {
+    // small draws, and single threads, are not split
+    EXPECT_EQ(stats, GCountRowBands(4, 0, 100, 100 * 100), 1);
+    EXPECT_EQ(stats, GCountRowBands(1, 0, 4000, 4000 * 4000), 1);
+    EXPECT_EQ(stats, GCountRowBands(4, 0, 4000, 4000 * 4000), 4);
+    EXPECT_EQ(stats, GCountRowBands(4, 0, 40, 40 * 100000), 40 / kGParallelRows_MinRows);
+
+    // the bands cover each row once
+    GThreadPool pool(4);
+    std::vector<std::atomic<int>> visits(1000);
+    std::atomic<int> bands{0};
+    GParallelRows(&pool, 3, 1003, 1000 * 1000, [&](int, int top, int bottom) {
+        bands += 1;
+        for (int y = top; y < bottom; ++y) {
+            visits[y - 3] += 1;
+        }
+    });
+    EXPECT_EQ(stats, bands.load(), 4);
+    EXPECT_TRUE(stats, std::all_of(visits.begin(), visits.end(), [](const std::atomic<int>& v) {
+        return v.load() == 1;
+    }));
+    bands = 0;
+    GParallelRows(nullptr, 0, 1000, 1000 * 1000, [&](int band, int top, int bottom) {
+        bands += 1;
+        EXPECT_TRUE(stats, band == 0 && top == 0 && bottom == 1000);
+    });
+    EXPECT_EQ(stats, bands.load(), 1);
+
+    // a clone shades the same colors
+    auto gradient = GCreateLinearGradient({10, 0}, {500, 300}, {1, 0, 0, 1}, {0, 0, 1, 0.5f});
+    if (auto clone = gradient->clone()) {
+        GPixel a[64], b[64];
+        EXPECT_TRUE(stats, gradient->setContext(GMatrix::Scale(1.5f, 1)) &&
+                           clone->setContext(GMatrix::Scale(1.5f, 1)));
+        gradient->shadeRow(3, 40, 64, a);
+        clone->shadeRow(3, 40, 64, b);
+        EXPECT_TRUE(stats, !memcmp(a, b, sizeof(a)));
+    }
+
+    // one draw big enough to be split has the same pixels as when it is not
+    const int w = 700, h = 500;
+    GBitmap serialBM, splitBM, image;
+    serialBM.alloc(w, h);
+    splitBM.alloc(w, h);
+    image.alloc(16, 16);
+    for (int y = 0; y < 16; ++y) {
+        for (int x = 0; x < 16; ++x) {
+            *image.getAddr(x, y) = GPixel_PackARGB(0xFF, x * 16, y * 16, 0x80);
+        }
+    }
+    auto bitmapShader = GCreateBitmapShader(image, GMatrix::Scale(30, 20));
+    for (GBlendMode mode : {GBlendMode::kSrcOver, GBlendMode::kXor, GBlendMode::kSrc}) {
+        auto serial = GCreateCanvas(serialBM), split = GCreateCanvas(splitBM, 4);
+        for (GCanvas* canvas : {serial.get(), split.get()}) {
+            canvas->clear({0.25f, 0.5f, 0.75f, 0.5f});
+            GPaint paint(bitmapShader);
+            canvas->drawRect(GRect::LTRB(-5, 3.5f, w + 5, h - 2), paint.setBlendMode(mode));
+            paint.setShader(gradient);
+            canvas->drawRect(GRect::WH(w, h), paint);
+            canvas->flush();
+        }
+        EXPECT_TRUE(stats, same_pixels(serialBM, splitBM));
+    }
+    free(serialBM.pixels());
+    free(splitBM.pixels());
+    free(image.pixels());
+}
+
+namespace {
+// A shader that can not be cloned, and notices if it is used by two threads at once.
+// (One color, since it ignores the ctm: each band's device rows start at 0.)
+class SharedOnlyShader : public GShader {
+public:
+    std::atomic<int> fInUse{0};
+    std::atomic<bool> fOverlapped{false};
+
+    bool isOpaque() override { return true; }
+    bool setContext(const GMatrix&) override { return true; }
+    void shadeRow(int x, int y, int count, GPixel row[]) override {
+        fOverlapped = fOverlapped || fInUse.fetch_add(1) > 0;
+        for (int i = 0; i < count; ++i) {
+            row[i] = GPixel_PackARGB(0xFF, 0x20, 0x80, 0x40);
+        }
+        fInUse.fetch_sub(1);
+    }
+};
+
+// Solid colors on whole (or half) pixels, so bands draw exactly what one canvas does
+void draw_band_scene(GCanvas* canvas, std::shared_ptr<GShader> shader) {
+    canvas->save();
+    canvas->rotate(0.3f);   // clear() ignores it
+    canvas->clear({1, 1, 1, 1});
+    canvas->restore();
+    for (int i = 0; i < 12; ++i) {
+        GPaint paint({i / 12.0f, 0.5f, 1 - i / 12.0f, 0.5f + i / 24.0f});
+        paint.setBlendMode(static_cast<GBlendMode>(i));
+        canvas->drawRect(GRect::XYWH(i * 13.0f, i * 17.0f, 60, 45.5f), paint);
+    }
+    GPathBuilder bu;
+    bu.addRect(GRect::LTRB(20, 20, 180, 200));
+    bu.addRect(GRect::LTRB(60, 60, 140, 160), GPathDirection::kCCW);
+    canvas->save();
+    canvas->clipRect(GRect::LTRB(10, 30, 170, 190));
+    canvas->drawPath(*bu.detach(), GPaint({0.25f, 0, 0, 1}));
+    canvas->restore();
+    canvas->drawRect(GRect::LTRB(100, 0, 200, 220), GPaint(shader));
+
+    // fractional and rotated, so any rounding that depends on the band would show
+    const GPoint star[] = {{30, 2}, {48, 56}, {2, 22}, {58, 22}, {12, 56}};
+    bu.addPolygon(star, GARRAY_COUNT(star));
+    auto path = bu.detach();
+    canvas->translate(40.37f, 70.81f);
+    canvas->rotate(0.7f);
+    canvas->scale(1.9f, 1.7f);
+    canvas->drawPath(*path, GPaint({0, 0.5f, 0, 0.75f}));
+    GPaint aa({0.5f, 0, 0.5f, 0.75f});
+    aa.setAntiAlias(true);
+    canvas->translate(10.5f, 3.3f);
+    canvas->drawPath(*path, aa);
+}
+}  // namespace
+
+static void test_band_replay(GTestStats* stats) {
+    const int w = 200, h = 220;
+    GBitmap serialBM, bandBM;
+    serialBM.alloc(w, h);
+    bandBM.alloc(w, h);
+    auto shader = std::make_shared<SharedOnlyShader>();
+    draw_band_scene(GCreateCanvas(serialBM).get(), shader);
+
+    GRecordingCanvas recorder;
+    draw_band_scene(&recorder, shader);
+    auto list = recorder.finishRecording();
+
+    GThreadPool pool(4);
+    for (int bands : {1, 3, 7, h, h + 5}) {
+        memset(bandBM.pixels(), 0, h * bandBM.rowBytes());
+        std::atomic<bool> overlapped{false};
+        EXPECT_TRUE(stats, GDrawInBands(bandBM, bands, &pool, [&](GCanvas* canvas) {
+            // each band has its own shader, so it can draw at the same time as the others
+            auto bandShader = std::make_shared<SharedOnlyShader>();
+            draw_band_scene(canvas, bandShader);
+            overlapped = overlapped || bandShader->fOverlapped;
+        }));
+        EXPECT_TRUE(stats, same_pixels(serialBM, bandBM));
+        EXPECT_TRUE(stats, !overlapped);
+
+        // the recorded shader can not be cloned, so these bands are drawn one at a time
+        memset(bandBM.pixels(), 0, h * bandBM.rowBytes());
+        EXPECT_TRUE(stats, GReplayInBands(*list, bandBM, bands, &pool));
+        EXPECT_TRUE(stats, same_pixels(serialBM, bandBM));
+        EXPECT_TRUE(stats, !shader->fOverlapped);
+    }
+    free(serialBM.pixels());
+    free(bandBM.pixels());
+}
+
+// Full and partial coverage, with runs wider than a chunk, through the shader blitters
+static void test_shader_blitters(GTestStats* stats) {
+    const int w = 700;
+    GRandom rand;
+    std::vector<GPixel> srcRow(w), opaqueRow(w), dstRow(w);
+    for (int i = 0; i < w; ++i) {
+        srcRow[i] = rand_premul(rand);
+        opaqueRow[i] = GPixel_PackARGB(0xFF, GPixel_GetR(srcRow[i]), GPixel_GetG(srcRow[i]),
+                                       GPixel_GetB(srcRow[i]));
+        dstRow[i] = rand_premul(rand);
+    }
+    RowShader translucent(srcRow.data()), opaque(opaqueRow.data(), true);
+    const GAlphaRun runs[] = {{5, 0xFF}, {300, 0x80}, {10, 0}, {280, 0xFF}, {1, 0x01}, {99, 0xFE},
+                              {0, 0}};
+    auto lerp = [](GPixel s, GPixel d, unsigned a) {
+        unsigned result = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            result |= (GMulDiv255((s >> shift) & 0xFF, a) +
+                       GMulDiv255((d >> shift) & 0xFF, 255 - a)) << shift;
+        }
+        return result;
+    };
+
+    GBitmap bm;
+    bm.alloc(w, 2);
+    GArena arena;
+    for (RowShader* shader : {&translucent, &opaque}) {
+        const GPixel* src = shader == &opaque ? opaqueRow.data() : srcRow.data();
+        bool same = true;
+        for (int m = 0; m < 12; ++m) {
+            const GBlendMode mode = static_cast<GBlendMode>(m);
+            memcpy(bm.getAddr(0, 0), dstRow.data(), w * sizeof(GPixel));
+            memcpy(bm.getAddr(0, 1), dstRow.data(), w * sizeof(GPixel));
+            GBlitter* blitter = GChooseBlitter(bm, mode, 0, shader, &arena);
+            blitter->blitH(3, 0, w - 3);
+            blitter->blitAntiH(0, 1, runs);
+            for (int i = 0; i < w; ++i) {
+                const GPixel full = GBlendPixel(mode, src[i], dstRow[i]);
+                same &= *bm.getAddr(i, 0) == (i < 3 ? dstRow[i] : full);
+            }
+            int x = 0;
+            for (const GAlphaRun* r = runs; r->fCount; ++r) {
+                for (int i = 0; i < r->fCount; ++i, ++x) {
+                    const GPixel full = GBlendPixel(mode, src[x], dstRow[x]);
+                    const GPixel expected = r->fAlpha == 0xFF ? full :
+                                            r->fAlpha == 0 ? dstRow[x] :
+                                            lerp(full, dstRow[x], r->fAlpha);
+                    same &= *bm.getAddr(x, 1) == expected;
+                }
+            }
+            arena.reset();
+        }
+        EXPECT_TRUE(stats, same);
+    }
+    free(bm.pixels());
+}
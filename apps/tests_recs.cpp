@@ -13,6 +13,7 @@
 #include "tests_pa2.cpp"
 #include "tests_pa3.cpp"
 #include "tests_pa4.cpp"
+#include "tests_pa5.cpp"
 
 const GTestRec gTestRecs[] = {
     { test_clear,       "clear"         },
@@ -31,6 +32,38 @@ const GTestRec gTestRecs[] = {
     { test_path_transform, "path_transform" },
     { test_path_nodraw, "path_nodraw" },
 
+    { test_thread_pool, "thread_pool"   },
+    { test_tile_canvas, "tile_canvas"   },
+    { test_recording,   "recording"     },
+    { test_path_winding, "path_winding" },
+    { test_antialias,   "antialias"     },
+    { test_blitter,     "blitter"       },
+    { test_blend_procs, "blend_procs"   },
+    { test_blend_simd,  "blend_simd"    },
+    { test_choose_blitter, "choose_blitter" },
+    { test_cpu_levels,  "cpu_levels"    },
+    { test_paint_analysis, "paint_analysis" },
+    { test_dst_tracker, "dst_tracker"   },
+    { test_deferred_clear, "deferred_clear" },
+    { test_clip_stack,  "clip_stack"    },
+    { test_canvas_clip, "canvas_clip"   },
+    { test_canvas_clip_defaults, "canvas_clip_defaults" },
+    { test_dirty_rect,  "dirty_rect"    },
+    { test_quick_reject, "quick_reject" },
+    { test_path_convexity, "path_convexity" },
+    { test_axis_rect,   "axis_rect"     },
+    { test_edge,        "edge"          },
+    { test_arena_reuse, "arena_reuse"   },
+    { test_batch_draws, "batch_draws"   },
+    { test_path_instances, "path_instances" },
+    { test_edge_cache,  "edge_cache"    },
+    { test_scan_converter, "scan_converter" },
+    { test_scan_converter_aa, "scan_converter_aa" },
+    { test_mask_cache,  "mask_cache"    },
+    { test_parallel_rows, "parallel_rows" },
+    { test_band_replay, "band_replay"   },
+    { test_shader_blitters, "shader_blitters" },
+
     { nullptr, nullptr },
 };
 
@@ -0,0 +1,90 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GWindow.h"
+#include "../include/GCanvas.h"
+#include "tests.h"
+
+/*
+ *  Tests for GWindow, which need SDL2 (see the window_tests target in the Makefile). Without a
+ *  display, they run with SDL_VIDEODRIVER=dummy (the default here, if it is not set).
+ */
+
+namespace {
+// Fills all it is asked to draw (only the requested area, since that is the canvas' clip)
+class FillWindow : public GWindow {
+public:
+    FillWindow(int w, int h) : GWindow(w, h) {}
+
+    GColor fColor = {1, 0, 0, 1};
+
+protected:
+    void onDraw(GCanvas* canvas) override {
+        canvas->drawRect(GRect::WH(this->width(), this->height()), GPaint(fColor));
+    }
+};
+}  // namespace
+
+static void test_window_upload(GTestStats* stats) {
+    const int w = 64, h = 48;
+    FillWindow window(w, h);
+    EXPECT_FALSE(stats, window.update());   // nothing was requested
+
+    // the texture is new, so all of it is uploaded
+    window.requestDraw();
+    EXPECT_TRUE(stats, window.update());
+    EXPECT_EQ(stats, window.lastUploadBytes(), (size_t)w * h * sizeof(GPixel));
+
+    // if the canvas reports what it changed, only that is uploaded
+    GBitmap probe;
+    probe.alloc(1, 1);
+    GIRect dirty;
+    const bool tracks = GCreateCanvas(probe)->takeDirtyRect(&dirty);
+    free(probe.pixels());
+    auto expected = [&](int width, int height) {
+        return (size_t)(tracks ? width * height : w * h) * sizeof(GPixel);
+    };
+
+    window.fColor = {0, 0, 1, 1};
+    window.requestDraw(GRect::LTRB(10, 20, 30, 25));
+    EXPECT_TRUE(stats, window.update());
+    EXPECT_EQ(stats, window.lastUploadBytes(), expected(20, 5));
+
+    // requests before an update are joined
+    window.fColor = {0, 1, 0, 1};
+    window.requestDraw(GRect::LTRB(2, 3, 6, 7));
+    window.requestDraw(GRect::LTRB(8, 8, 12, 10));
+    EXPECT_TRUE(stats, window.update());
+    EXPECT_EQ(stats, window.lastUploadBytes(), expected(10, 7));
+    EXPECT_FALSE(stats, window.update());
+
+    // a full request is still uploaded in full
+    window.requestDraw();
+    EXPECT_TRUE(stats, window.update());
+    EXPECT_EQ(stats, window.lastUploadBytes(), (size_t)w * h * sizeof(GPixel));
+    EXPECT_EQ(stats, window.totalUploadBytes(),
+              (size_t)w * h * sizeof(GPixel) * 2 + expected(20, 5) + expected(10, 7));
+}
+
+const GTestRec gTestRecs[] = {
+    { test_window_upload, "window_upload" },
+
+    { nullptr, nullptr },
+};
+
+bool gTestSuite_Verbose;
+bool gTestSuite_CrashOnFailure;
+
+extern int main_tests(int argc, const char* argv[]);
+
+int main(int argc, const char* argv[]) {
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        printf("window_tests: can't init SDL: %s\n", SDL_GetError());
+        return -1;
+    }
+    const int result = main_tests(argc, argv);
+    SDL_Quit();
+    return result;
+}
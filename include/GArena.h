@@ -0,0 +1,125 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GArena_DEFINED
+#define GArena_DEFINED
+
+#include "GTypes.h"
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ *  A bump allocator. Memory is handed out from large blocks, and is only released when the
+ *  arena is reset() or destroyed. Objects made with make() have their destructors called at
+ *  that time (in reverse order).
+ *
+ *  reset() keeps the blocks, so an arena that is reused for similar work stops allocating
+ *  once it has grown to its working size. e.g. a canvas can keep one arena for the edges,
+ *  spans and shader rows of its draws, and reset it at the end of each draw.
+ *
+ *  Blocks come from operator new, so they are seen by programs that count heap allocations
+ *  (see bench).
+ */
+class GArena {
+public:
+    GArena(size_t firstBlockSize = 4096) : fNextBlockSize(firstBlockSize) {}
+    ~GArena() {
+        this->reset();
+        for (auto& b : fBlocks) {
+            ::operator delete(b.fStorage);
+        }
+    }
+
+    GArena(const GArena&) = delete;
+    GArena& operator=(const GArena&) = delete;
+
+    void* alloc(size_t size, size_t align) {
+        assert(align && (align & (align - 1)) == 0);
+        for (;;) {
+            if (fCurr < fBlocks.size()) {
+                const Block& b = fBlocks[fCurr];
+                size_t offset = (fCursor + align - 1) & ~(align - 1);
+                if (offset + size <= b.fSize) {
+                    fCursor = offset + size;
+                    return b.fStorage + offset;
+                }
+                if (fCurr + 1 < fBlocks.size()) {
+                    fCurr += 1;
+                    fCursor = 0;
+                    continue;
+                }
+            }
+            this->addBlock(size + align);
+        }
+    }
+
+    template <typename T, typename... Args> T* make(Args&&... args) {
+        T* obj = new (this->alloc(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value) {
+            fDtors.push_back({obj, [](void* p) { static_cast<T*>(p)->~T(); }});
+        }
+        return obj;
+    }
+
+    // Uninitialized storage for count T's. T must be trivially destructible.
+    template <typename T> T* makeArray(int count) {
+        static_assert(std::is_trivially_destructible<T>::value, "");
+        return static_cast<T*>(this->alloc(sizeof(T) * count, alignof(T)));
+    }
+
+    template <typename T> T* copyArray(const T src[], int count) {
+        T* dst = this->makeArray<T>(count);
+        std::copy(src, src + count, dst);
+        return dst;
+    }
+
+    /**
+     *  Destroy all objects made by the arena, and make all of its memory available again.
+     */
+    void reset() {
+        for (size_t i = fDtors.size(); i > 0; --i) {
+            fDtors[i - 1].fProc(fDtors[i - 1].fObj);
+        }
+        fDtors.clear();
+        fCurr = 0;
+        fCursor = 0;
+    }
+
+    // Total bytes in all blocks (used or not)
+    size_t capacity() const {
+        size_t total = 0;
+        for (auto& b : fBlocks) {
+            total += b.fSize;
+        }
+        return total;
+    }
+
+private:
+    struct Block {
+        char*  fStorage;
+        size_t fSize;
+    };
+    struct Dtor {
+        void* fObj;
+        void (*fProc)(void*);
+    };
+
+    std::vector<Block> fBlocks;
+    std::vector<Dtor>  fDtors;
+    size_t             fCurr = 0;      // index of the block we're allocating from
+    size_t             fCursor = 0;    // offset into that block
+    size_t             fNextBlockSize;
+
+    void addBlock(size_t minSize) {
+        size_t size = std::max(minSize, fNextBlockSize);
+        fNextBlockSize = size * 2;
+        fBlocks.push_back({(char*)::operator new(size), size});
+        fCurr = fBlocks.size() - 1;
+        fCursor = 0;
+    }
+};
+
+#endif
@@ -10,6 +10,7 @@
 #include <string>
 
 class GBitmap;
+class GIRect;
 class GPath;
 class GPoint;
 class GRect;
@@ -19,7 +20,7 @@ public:
     virtual ~GCanvas() {}
 
     /**
-     *  Save off a copy of the canvas state (CTM), to be later used if the balancing call to
+     *  Save off a copy of the canvas state (CTM and clip), to be later used if the balancing call to
      *  restore() is made. Calls to save/restore can be nested:
      *  save();
      *      save();
@@ -32,7 +33,7 @@ public:
     virtual void save() = 0;
 
     /**
-     *  Copy the canvas state (CTM) that was record in the correspnding call to save() back into
+     *  Copy the canvas state (CTM and clip) that was record in the correspnding call to save() back into
      *  the canvas. It is an error to call restore() if there has been no previous call to save().
      */
     virtual void restore() = 0;
@@ -45,8 +46,37 @@ public:
      */
     virtual void concat(const GMatrix& matrix) = 0;
 
+    /**
+     *  Intersect the clip with the rectangle, transformed by the CTM. Only pixels whose centers
+     *  are inside the clip are affected by the draws (but see clear()). The canvas is
+     *  constructed with the clip set to the bounds of its bitmap.
+     *
+     *  The default calls clipPath() with the rectangle.
+     */
+    virtual void clipRect(const GRect& rect);
+
+    /**
+     *  Intersect the clip with the path (winding fill), transformed by the CTM.
+     *
+     *  NOTE: the default does NOT clip. It does nothing, so that canvases written before
+     *  clipping still compile, but they draw as if there were no clip (and so does clipRect(),
+     *  unless it is overridden too). A canvas must override this to support clipping.
+     */
+    virtual void clipPath(const GPath&) {}
+
+    /**
+     *  Return true if drawing anything inside the rectangle, transformed by the CTM, would
+     *  certainly not change any pixel inside the clip. Callers can then skip building the draw.
+     *  Returning false does not mean that a pixel will change. The draws reject themselves the
+     *  same way, so calling this first is never required.
+     *
+     *  The default never rejects.
+     */
+    virtual bool quickReject(const GRect&) const { return false; }
+
     /**
      *  Fill the entire canvas with the specified color, using kSrc porter-duff mode.
+     *  This ignores the clip.
      */
     virtual void clear(const GColor&) = 0;
 
@@ -69,6 +99,66 @@ public:
      */
     virtual void drawPath(const GPath&, const GPaint&) = 0;
 
+    /**
+     *  Batched draws. Each is the same as making the single draw for each i, in order, e.g.
+     *      drawRect(rects[i], paints[i])
+     *  but a canvas can override them to do per-draw setup (classifying the CTM, choosing blend
+     *  procs for runs of equal paints, clip bounds) once for the whole batch.
+     */
+    virtual void drawRects(const GRect rects[], const GPaint paints[], int count) {
+        for (int i = 0; i < count; ++i) {
+            this->drawRect(rects[i], paints[i]);
+        }
+    }
+
+    // Polygon i has counts[i] points, which follow those of polygon i - 1 in pts[]
+    virtual void drawConvexPolygons(const GPoint pts[], const int counts[], const GPaint paints[],
+                                    int polyCount) {
+        for (int i = 0; i < polyCount; ++i) {
+            this->drawConvexPolygon(pts, counts[i], paints[i]);
+            pts += counts[i];
+        }
+    }
+
+    virtual void drawPaths(const GPath* const paths[], const GPaint paints[], int count) {
+        for (int i = 0; i < count; ++i) {
+            this->drawPath(*paths[i], paints[i]);
+        }
+    }
+
+    /**
+     *  Draw the path n times: instance i with the CTM preconcatenated with matrices[i], and with
+     *  paints[i]. The same as
+     *      save(); concat(matrices[i]); drawPath(path, paints[i]); restore();
+     *  for each i, but a canvas can set up the path (e.g. its edges) once, and only re-map it
+     *  per instance (or just offset it, for instances that differ by a translate).
+     */
+    virtual void drawPathInstances(const GPath& path, const GMatrix matrices[],
+                                   const GPaint paints[], int n) {
+        for (int i = 0; i < n; ++i) {
+            this->save();
+            this->concat(matrices[i]);
+            this->drawPath(path, paints[i]);
+            this->restore();
+        }
+    }
+
+    /**
+     *  Some canvases defer their drawing (e.g. to batch it up across threads). Calling flush()
+     *  ensures that all previous calls have been resolved into the pixels of the bitmap.
+     *  The canvas also flushes when it is destroyed.
+     */
+    virtual void flush() {}
+
+    /**
+     *  If the canvas tracks which pixels its calls change, set dirty to (at least) the device
+     *  bounds of every pixel changed since the previous call (or since it was created), and
+     *  return true. dirty is empty if nothing changed. Call flush() first.
+     *
+     *  Returning false means the canvas does not track this: any pixel may have changed.
+     */
+    virtual bool takeDirtyRect(GIRect* dirty) { return false; }
+
     // Helpers
 
     void translate(float x, float y) {
@@ -99,6 +189,19 @@ public:
  */
 std::unique_ptr<GCanvas> GCreateCanvas(const GBitmap& bitmap);
 
+/**
+ *  Like GCreateCanvas(bitmap), but the returned canvas may spread its work across threadCount
+ *  threads. The calls are recorded (see GRecordingCanvas), and at flush() (or when the canvas
+ *  is destroyed) the recording is played back into one band of rows per thread, each with its
+ *  own GCreateCanvas(bitmap), in parallel (see GThreadPool). Drawing is deferred until flush().
+ *
+ *  After flush(), the pixels must be identical to those produced by GCreateCanvas(bitmap)
+ *  for the same sequence of calls, for every GBlendMode.
+ *
+ *  If threadCount <= 1, this returns a serial canvas.
+ */
+std::unique_ptr<GCanvas> GCreateCanvas(const GBitmap& bitmap, int threadCount);
+
 /**
  *  Implement this, drawing into the provided canvas, and returning the title of your artwork.
  */
@@ -31,6 +31,14 @@ public:
     GBlendMode getBlendMode() const { return fMode; }
     GPaint&    setBlendMode(GBlendMode m) { fMode = m; return *this; }
 
+    /**
+     *  If true, drawPath and drawConvexPolygon compute the exact area of each pixel that the
+     *  geometry covers, and blend the src into the dst in proportion to that coverage.
+     *  If false (the default), a pixel is either drawn or not, based on its center.
+     */
+    bool    isAntiAlias() const { return fAntiAlias; }
+    GPaint& setAntiAlias(bool aa) { fAntiAlias = aa; return *this; }
+
     GShader* peekShader() const { return fShader.get(); }
     std::shared_ptr<GShader> shareShader() const { return fShader; }
     GPaint&  setShader(std::shared_ptr<GShader> s) { fShader = s; return *this; }
@@ -39,6 +47,7 @@ private:
     GColor                      fColor = {0, 0, 0, 1};
     std::shared_ptr<GShader>    fShader;
     GBlendMode                  fMode = GBlendMode::kSrcOver;
+    bool                        fAntiAlias = false;
 };
 
 #endif
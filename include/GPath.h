@@ -5,6 +5,7 @@
 #include "GPoint.h"
 #include "GRect.h"
 
+#include <atomic>
 #include <vector>
 
 enum GPathVerb {
@@ -28,6 +29,30 @@ public:
 
     size_t countPoints() const { return fPts.size(); }
 
+    /**
+     *  Return true if the path is a single contour (one kMove, then only kLines) that is convex:
+     *  it turns the same way at every corner and goes around only once. Every horizontal line
+     *  then crosses it at most twice, so it can be filled like a convex polygon, without
+     *  tracking winding. Degenerate contours (e.g. all points on a line) count as convex.
+     *
+     *  This is computed the first time it is asked for, and then remembered (safely, even if
+     *  the path is shared between threads). transform() passes it on to the new path.
+     */
+    bool isConvex() const;
+
+    /**
+     *  Return true if the path is a single contour that is a rectangle with sides parallel to
+     *  the axes, and set rect to it (e.g. what GPathBuilder::addRect() makes).
+     */
+    bool isRect(GRect* rect) const;
+
+    /**
+     *  Return a non-zero id that no path with different points or verbs has. Paths never
+     *  change, so anything computed from a path (e.g. its edges) can be cached under this id.
+     *  A copy of a path has the same id.
+     */
+    uint32_t uniqueID() const { return fUniqueID; }
+
     /**
      *  Create a new path by transforming the points in this path.
      */
@@ -95,13 +120,33 @@ public:
     GPath(std::vector<GPoint> pts, std::vector<GPathVerb> vbs)
         : fPts(std::move(pts))
         , fVbs(std::move(vbs))
+        , fUniqueID(NextUniqueID())
+    {}
+
+    GPath(const GPath& src)
+        : std::enable_shared_from_this<GPath>()
+        , fPts(src.fPts)
+        , fVbs(src.fVbs)
+        , fUniqueID(src.fUniqueID)
+        , fConvexity(src.fConvexity.load(std::memory_order_relaxed))
     {}
 
 private:
     friend class GPathBuilder;
 
+    enum Convexity : int8_t {
+        kUnknown_Convexity,     // not computed yet
+        kConvex_Convexity,
+        kConcave_Convexity,     // or more than one contour
+    };
+    Convexity computeConvexity() const;
+
+    static uint32_t NextUniqueID();
+
     const std::vector<GPoint>    fPts;
     const std::vector<GPathVerb> fVbs;
+    const uint32_t               fUniqueID;
+    mutable std::atomic<int8_t>  fConvexity{kUnknown_Convexity};
 };
 
 #endif
@@ -0,0 +1,119 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GRecordingCanvas_DEFINED
+#define GRecordingCanvas_DEFINED
+
+#include "GArena.h"
+#include "GCanvas.h"
+#include <unordered_map>
+
+/**
+ *  An immutable list of canvas calls, made by GRecordingCanvas.
+ *
+ *  All of the commands (and their paints and points) live in an arena owned by the list, so
+ *  playback() does not allocate. Paths are shared, immutable copies (see GRecordingCanvas).
+ */
+class GDisplayList {
+public:
+    enum class Op : uint8_t {
+        kSave,
+        kRestore,
+        kConcat,
+        kClipRect,
+        kClipPath,
+        kClear,
+        kDrawRect,
+        kDrawConvexPolygon,
+        kDrawPath,
+    };
+
+    struct Rec;
+
+    int count() const { return (int)fRecs.size(); }
+
+    /**
+     *  Issue the recorded calls, in order, to the canvas. The canvas' CTM and clip are saved and restored
+     *  around the playback, so an unbalanced recording does not leak state into the canvas, nor pop any
+     *  of the canvas' own saves.
+     */
+    void playback(GCanvas*) const;
+
+    // For analysis: the opcode of the index'th call.
+    Op op(int index) const;
+
+private:
+    GArena                  fArena;
+    std::vector<const Rec*> fRecs;
+
+    friend class GRecordingCanvas;
+};
+
+/**
+ *  A canvas that draws nothing, but instead records its calls into a GDisplayList.
+ *
+ *      GRecordingCanvas recorder;
+ *      scene(&recorder);
+ *      auto list = recorder.finishRecording();
+ *      for (...) {
+ *          list->playback(canvas);
+ *      }
+ *
+ *  To record a new list every frame without allocating, give each list back once it has been
+ *  played, and the next recording reuses its storage:
+ *
+ *      scene(&recorder);
+ *      auto list = recorder.finishRecording();
+ *      list->playback(canvas);
+ *      recorder.recycle(std::move(list));
+ *
+ *  The recorder copies each path the first time it sees its GPath::uniqueID(), and every record
+ *  of that path (in this list, and in the next one) shares the copy. So a path that is drawn many
+ *  times, or recorded again every frame, is only copied once.
+ */
+class GRecordingCanvas : public GCanvas {
+public:
+    GRecordingCanvas();
+    ~GRecordingCanvas() override;
+
+    void save() override;
+    // A restore without a matching save (in this recording) is dropped.
+    void restore() override;
+    void concat(const GMatrix&) override;
+    void clipRect(const GRect&) override;
+    void clipPath(const GPath&) override;
+    void clear(const GColor&) override;
+    void drawRect(const GRect&, const GPaint&) override;
+    void drawConvexPolygon(const GPoint[], int count, const GPaint&) override;
+    void drawPath(const GPath&, const GPaint&) override;
+
+    /**
+     *  Return the calls recorded so far, and begin a new (empty) recording.
+     */
+    std::unique_ptr<GDisplayList> finishRecording();
+
+    /**
+     *  Give back a list (from finishRecording()) that is no longer needed. Its calls are
+     *  dropped, and the recording after the current one reuses its arena and array of calls.
+     */
+    void recycle(std::unique_ptr<GDisplayList>);
+
+private:
+    struct SharedPath {
+        std::shared_ptr<GPath> fPath;
+        int                    fGeneration;    // of the last recording that used it
+    };
+
+    std::unique_ptr<GDisplayList> fList;
+    std::unique_ptr<GDisplayList> fSpare;          // from recycle(), emptied
+    int                           fSaveCount = 0;  // unmatched saves in fList
+    // The copies used by fList (generation fGeneration) or by the list before it
+    std::unordered_map<uint32_t, SharedPath> fPaths;
+    int                                      fGeneration = 0;
+
+    template <typename T, typename... Args> void append(Args&&...);
+    std::shared_ptr<GPath> sharedPath(const GPath&);
+};
+
+#endif
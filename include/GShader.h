@@ -32,6 +32,15 @@ public:
      *  can hold at least [count] entries.
      */
     virtual void shadeRow(int x, int y, int count, GPixel row[]) = 0;
+
+    /**
+     *  Return a new shader that produces the same colors as this one, with its own context:
+     *  it can be given its own setContext() and shadeRow() calls, on another thread, while this
+     *  one is in use. A canvas uses this to split one large draw across threads.
+     *
+     *  Returns null if the shader can not be copied; such draws are done on one thread.
+     */
+    virtual std::shared_ptr<GShader> clone() const { return nullptr; }
 };
 
 /**
@@ -0,0 +1,49 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GThreadPool_DEFINED
+#define GThreadPool_DEFINED
+
+#include "GTypes.h"
+#include <functional>
+
+/**
+ *  A small work-stealing pool. Each worker owns a queue of tasks; when its own queue is empty,
+ *  a worker steals from the front of another worker's queue. A thread that waits (in wait() or
+ *  parallelFor()) also runs tasks, of any kind, until the ones it waits for have finished.
+ *
+ *  A pool created with threadCount <= 1 spawns no threads; tasks are run by wait().
+ */
+class GThreadPool {
+public:
+    explicit GThreadPool(int threadCount);
+    ~GThreadPool();
+
+    int threadCount() const { return fThreadCount; }
+
+    /**
+     *  Queue a task. It may start running before this returns.
+     */
+    void add(std::function<void()> task);
+
+    /**
+     *  Run tasks on the calling thread until every task added with add() so far (including
+     *  those that tasks added) has finished. Not for use inside those tasks, which would wait
+     *  for themselves: they can call parallelFor().
+     */
+    void wait();
+
+    /**
+     *  Call fn(i) for i in [0...count), spread across the pool, and wait for just those. This
+     *  may be called from inside a task (e.g. nested parallelFor calls).
+     */
+    void parallelFor(int count, const std::function<void(int)>& fn);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> fImpl;
+    const int fThreadCount;
+};
+
+#endif
@@ -0,0 +1,43 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GAxisRect.h"
+#include <algorithm>
+
+static bool same(GPoint a, GPoint b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+bool GPolygonIsAxisRect(const GPoint pts[], int count, GRect* rect) {
+    GPoint corners[4];
+    int n = 0;
+    for (int i = 0; i < count; ++i) {
+        if (n > 0 && same(pts[i], corners[n - 1])) {
+            continue;
+        }
+        if (n == 4) {
+            // all that may follow is an explicit close
+            for (; i < count; ++i) {
+                if (!same(pts[i], corners[0])) {
+                    return false;
+                }
+            }
+            break;
+        }
+        corners[n++] = pts[i];
+    }
+    if (n != 4) {
+        return false;
+    }
+
+    const GPoint a = corners[0], b = corners[1], c = corners[2], d = corners[3];
+    const bool vertFirst = a.x == b.x && b.y == c.y && c.x == d.x && d.y == a.y,
+               horzFirst = a.y == b.y && b.x == c.x && c.y == d.y && d.x == a.x;
+    if (!vertFirst && !horzFirst) {
+        return false;
+    }
+    *rect = GRect::LTRB(std::min(a.x, c.x), std::min(a.y, c.y),
+                        std::max(a.x, c.x), std::max(a.y, c.y));
+    return true;
+}
@@ -0,0 +1,22 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GAxisRect_DEFINED
+#define GAxisRect_DEFINED
+
+#include "../include/GPoint.h"
+#include "../include/GRect.h"
+
+/**
+ *  Return true if the closed polygon pts[0..count) is a rectangle whose sides are parallel to
+ *  the axes (in either direction, starting at any corner), and set rect to it. Repeated
+ *  points are ignored, so e.g. a closing point equal to the first one is fine.
+ *
+ *  A canvas calls this on device-space points (i.e. after the CTM), and if it returns true,
+ *  fills rect.round() with GBlitter::blitRect() instead of walking edges. The pixels are the
+ *  same: those whose centers are inside the rect.
+ */
+bool GPolygonIsAxisRect(const GPoint pts[], int count, GRect* rect);
+
+#endif
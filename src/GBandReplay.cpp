@@ -0,0 +1,201 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GBandReplay.h"
+#include "../include/GRecordingCanvas.h"
+#include "../include/GShader.h"
+#include "../include/GThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace {
+
+/*
+ *  Forwards every call to a band's canvas, which is over the whole bitmap down to the band's
+ *  bottom, and clipped to the band's rows. clear() ignores the clip, so it becomes a kSrc fill
+ *  of those rows instead, drawn with the CTM undone.
+ */
+class BandRowsCanvas : public GCanvas {
+public:
+    BandRowsCanvas(GCanvas* canvas, const GIRect& rows) : fCanvas(canvas), fRows(rows) {
+        fCanvas->clipRect(GRect::LTRB(rows.left, rows.top, rows.right, rows.bottom));
+        fCTMs.push_back(GMatrix());
+    }
+
+    void save() override {
+        fCTMs.push_back(fCTMs.back());
+        fCanvas->save();
+    }
+    void restore() override {
+        fCTMs.pop_back();
+        fCanvas->restore();
+    }
+    void concat(const GMatrix& m) override {
+        fCTMs.back() = fCTMs.back() * m;
+        fCanvas->concat(m);
+    }
+    void clipRect(const GRect& r) override { fCanvas->clipRect(r); }
+    void clipPath(const GPath& p) override { fCanvas->clipPath(p); }
+    bool quickReject(const GRect& r) const override { return fCanvas->quickReject(r); }
+
+    void clear(const GColor& color) override {
+        const GMatrix& ctm = fCTMs.back();
+        const auto inverse = ctm.invert();
+        if (!inverse) {
+            return;     // nothing can be drawn with this CTM
+        }
+        GPaint paint(color);
+        paint.setBlendMode(GBlendMode::kSrc);
+        fCanvas->save();
+        fCanvas->concat(*inverse);
+        // a pixel larger, for the rounding in ctm * inverse: the clip has the exact rows
+        fCanvas->drawRect(GRect::LTRB(fRows.left - 1, fRows.top - 1, fRows.right + 1,
+                                      fRows.bottom + 1), paint);
+        fCanvas->restore();
+    }
+
+    void drawRect(const GRect& r, const GPaint& p) override { fCanvas->drawRect(r, p); }
+    void drawConvexPolygon(const GPoint pts[], int count, const GPaint& p) override {
+        fCanvas->drawConvexPolygon(pts, count, p);
+    }
+    void drawPath(const GPath& path, const GPaint& p) override { fCanvas->drawPath(path, p); }
+    void drawRects(const GRect rects[], const GPaint paints[], int count) override {
+        fCanvas->drawRects(rects, paints, count);
+    }
+    void drawConvexPolygons(const GPoint pts[], const int counts[], const GPaint paints[],
+                            int polyCount) override {
+        fCanvas->drawConvexPolygons(pts, counts, paints, polyCount);
+    }
+    void drawPaths(const GPath* const paths[], const GPaint paints[], int count) override {
+        fCanvas->drawPaths(paths, paints, count);
+    }
+    void drawPathInstances(const GPath& path, const GMatrix matrices[], const GPaint paints[],
+                           int n) override {
+        fCanvas->drawPathInstances(path, matrices, paints, n);
+    }
+    void flush() override { fCanvas->flush(); }
+
+private:
+    GCanvas*             fCanvas;
+    const GIRect         fRows;
+    std::vector<GMatrix> fCTMs;     // to undo for clear()
+};
+
+/*
+ *  Forwards every call to a band's canvas, or (if there is none) just looks at the paints:
+ *  each shader is replaced by this band's own clone of it.
+ */
+class BandCanvas : public GCanvas {
+public:
+    BandCanvas(GCanvas* band) : fBand(band) {}
+
+    // True if every shader seen so far could be cloned
+    bool allCloned() const { return fAllCloned; }
+
+    void save() override { if (fBand) fBand->save(); }
+    void restore() override { if (fBand) fBand->restore(); }
+    void concat(const GMatrix& m) override { if (fBand) fBand->concat(m); }
+    void clipRect(const GRect& r) override { if (fBand) fBand->clipRect(r); }
+    void clipPath(const GPath& p) override { if (fBand) fBand->clipPath(p); }
+    void clear(const GColor& c) override { if (fBand) fBand->clear(c); }
+
+    void drawRect(const GRect& r, const GPaint& p) override {
+        const GPaint& paint = this->bandPaint(p);
+        if (fBand) {
+            fBand->drawRect(r, paint);
+        }
+    }
+    void drawConvexPolygon(const GPoint pts[], int count, const GPaint& p) override {
+        const GPaint& paint = this->bandPaint(p);
+        if (fBand) {
+            fBand->drawConvexPolygon(pts, count, paint);
+        }
+    }
+    void drawPath(const GPath& path, const GPaint& p) override {
+        const GPaint& paint = this->bandPaint(p);
+        if (fBand) {
+            fBand->drawPath(path, paint);
+        }
+    }
+
+private:
+    const GPaint& bandPaint(const GPaint& paint) {
+        const GShader* shader = paint.peekShader();
+        if (!shader) {
+            return paint;
+        }
+        auto iter = std::find_if(fClones.begin(), fClones.end(), [shader](const Clone& c) {
+            return c.fOriginal == shader;
+        });
+        if (iter == fClones.end()) {
+            fClones.push_back({shader, shader->clone()});
+            iter = fClones.end() - 1;
+            fAllCloned &= iter->fClone != nullptr;
+        }
+        if (!iter->fClone) {
+            return paint;   // only drawn this way when the bands are not drawn at the same time
+        }
+        fPaint = paint;
+        fPaint.setShader(iter->fClone);
+        return fPaint;
+    }
+
+    struct Clone {
+        const GShader*           fOriginal;
+        std::shared_ptr<GShader> fClone;
+    };
+
+    GCanvas*           fBand;
+    std::vector<Clone> fClones;
+    GPaint             fPaint;
+    bool               fAllCloned = true;
+};
+
+}  // namespace
+
+bool GDrawInBands(const GBitmap& bitmap, int bandCount, GThreadPool* pool,
+                  const std::function<void(GCanvas*)>& draw) {
+    const int height = bitmap.height();
+    bandCount = std::max(1, std::min(bandCount, height));
+
+    std::atomic<bool> ok{true};
+    auto drawBand = [&](int band) {
+        const int top = (int)((int64_t)height * band / bandCount),
+                  bottom = (int)((int64_t)height * (band + 1) / bandCount);
+        // the same device coordinates as the whole bitmap, so the same math as a serial draw
+        GBitmap view(bitmap.width(), bottom, bitmap.rowBytes(), bitmap.pixels(),
+                     bitmap.isOpaque());
+        auto canvas = GCreateCanvas(view);
+        if (!canvas) {
+            ok = false;
+            return;
+        }
+        BandRowsCanvas rows(canvas.get(), GIRect::LTRB(0, top, bitmap.width(), bottom));
+        draw(&rows);
+        rows.flush();
+    };
+
+    if (pool) {
+        pool->parallelFor(bandCount, drawBand);
+    } else {
+        for (int band = 0; band < bandCount; ++band) {
+            drawBand(band);
+        }
+    }
+    return ok;
+}
+
+bool GReplayInBands(const GDisplayList& list, const GBitmap& bitmap, int bandCount,
+                    GThreadPool* pool) {
+    BandCanvas finder(nullptr);
+    list.playback(&finder);
+    if (!finder.allCloned()) {
+        pool = nullptr;
+    }
+    return GDrawInBands(bitmap, bandCount, pool, [&list](GCanvas* canvas) {
+        BandCanvas bandCanvas(canvas);
+        list.playback(&bandCanvas);
+    });
+}
@@ -0,0 +1,44 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GBandReplay_DEFINED
+#define GBandReplay_DEFINED
+
+#include "../include/GBitmap.h"
+
+#include <functional>
+
+class GCanvas;
+class GDisplayList;
+class GThreadPool;
+
+/**
+ *  Draw a scene into the bitmap as bandCount horizontal bands of rows, at the same time
+ *  (spread across pool, if it is not null).
+ *
+ *  Each band gets its own canvas (from GCreateCanvas()) over the bitmap down to the band's
+ *  bottom, clipped to the band's rows, and draw(canvas) issues the whole scene into it. Nothing
+ *  needs to be binned: this is coarse parallelism, where every band pays for walking every
+ *  command. The canvas passed to draw() turns clear() into a fill of just the band's rows.
+ *
+ *  draw() may be called on several threads at once, so it must not share anything that a draw
+ *  changes (e.g. a shader, whose context is set by each draw) with the other bands.
+ *
+ *  Each band draws with the same device coordinates (and so the same math) as one canvas over
+ *  the whole bitmap would, so the pixels are identical to drawing the scene that way, given a
+ *  canvas whose clip only selects pixels.
+ *
+ *  Returns false if a band's canvas could not be created.
+ */
+bool GDrawInBands(const GBitmap&, int bandCount, GThreadPool*,
+                  const std::function<void(GCanvas*)>& draw);
+
+/**
+ *  GDrawInBands() for a recorded scene: each band plays back the whole list. The bands share
+ *  the list's shaders, so each band uses its own clones of them (see GShader::clone()). If a
+ *  shader can not be cloned, the bands are drawn one after another instead.
+ */
+bool GReplayInBands(const GDisplayList&, const GBitmap&, int bandCount, GThreadPool*);
+
+#endif
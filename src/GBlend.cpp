@@ -0,0 +1,152 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GBlend.h"
+#include "GCpu.h"
+
+#include <atomic>
+
+/*
+ *  Every mode in GBlendMode.h has the form   S * fs + D * fd
+ *  where fs and fd are each one of  0, 1, Sa, Da, 1 - Sa, 1 - Da.
+ *  These return those factors (scaled to 0...255) for each mode, so that once a mode is a
+ *  template parameter, the compiler folds away the factors (and loads) that it does not need.
+ */
+template <GBlendMode M> static inline unsigned src_factor(unsigned sa, unsigned da) {
+    switch (M) {
+        case GBlendMode::kClear:    return 0;
+        case GBlendMode::kSrc:      return 255;
+        case GBlendMode::kDst:      return 0;
+        case GBlendMode::kSrcOver:  return 255;
+        case GBlendMode::kDstOver:  return 255 - da;
+        case GBlendMode::kSrcIn:    return da;
+        case GBlendMode::kDstIn:    return 0;
+        case GBlendMode::kSrcOut:   return 255 - da;
+        case GBlendMode::kDstOut:   return 0;
+        case GBlendMode::kSrcATop:  return da;
+        case GBlendMode::kDstATop:  return 255 - da;
+        case GBlendMode::kXor:      return 255 - da;
+    }
+    return 0;
+}
+
+template <GBlendMode M> static inline unsigned dst_factor(unsigned sa, unsigned da) {
+    switch (M) {
+        case GBlendMode::kClear:    return 0;
+        case GBlendMode::kSrc:      return 0;
+        case GBlendMode::kDst:      return 255;
+        case GBlendMode::kSrcOver:  return 255 - sa;
+        case GBlendMode::kDstOver:  return 255;
+        case GBlendMode::kSrcIn:    return 0;
+        case GBlendMode::kDstIn:    return sa;
+        case GBlendMode::kSrcOut:   return 0;
+        case GBlendMode::kDstOut:   return 255 - sa;
+        case GBlendMode::kSrcATop:  return 255 - sa;
+        case GBlendMode::kDstATop:  return sa;
+        case GBlendMode::kXor:      return 255 - sa;
+    }
+    return 0;
+}
+
+// GMulDiv255() applied to all 4 components at once: two components per 32bit lane.
+static inline GPixel mul_div255_x4(GPixel p, unsigned f) {
+    const uint32_t mask = 0x00FF00FF;
+    uint32_t rb = (p & mask) * f + 0x00800080;
+    uint32_t ag = ((p >> 8) & mask) * f + 0x00800080;
+    rb = ((rb + ((rb >> 8) & mask)) >> 8) & mask;
+    ag = ((ag + ((ag >> 8) & mask)) >> 8) & mask;
+    return rb | (ag << 8);
+}
+
+static inline GPixel scale(GPixel p, unsigned f) {
+    return f == 0 ? 0 : f == 255 ? p : mul_div255_x4(p, f);
+}
+
+// sa is passed separately so the opaque-color procs can pass a constant 255
+template <GBlendMode M> static inline GPixel blend(GPixel s, unsigned sa, GPixel d) {
+    const unsigned da = GPixel_GetA(d);
+    // each component's sum is <= 255 for premultiplied inputs, so no carries between lanes
+    return scale(s, src_factor<M>(sa, da)) + scale(d, dst_factor<M>(sa, da));
+}
+
+template <GBlendMode M, GSrcKind K> static void blend_color(GPixel dst[], GPixel src, int count) {
+    static_assert(K != GSrcKind::kShaderRow, "");
+    if (M == GBlendMode::kDst) {
+        return;
+    }
+    const unsigned sa = (K == GSrcKind::kOpaqueColor) ? 255 : GPixel_GetA(src);
+    if (M == GBlendMode::kClear || M == GBlendMode::kSrc) {
+        // the result does not depend on the dst
+        const GPixel value = blend<M>(src, sa, 0);
+        for (int i = 0; i < count; ++i) {
+            dst[i] = value;
+        }
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        dst[i] = blend<M>(src, sa, dst[i]);
+    }
+}
+
+template <GBlendMode M> static void blend_row(GPixel dst[], const GPixel src[], int count) {
+    for (int i = 0; i < count; ++i) {
+        dst[i] = blend<M>(src[i], GPixel_GetA(src[i]), dst[i]);
+    }
+}
+
+static const GBlendProcs gScalarProcs = {
+    G_EACH_BLENDMODE(blend_color, GSrcKind::kOpaqueColor),
+    G_EACH_BLENDMODE(blend_color, GSrcKind::kTranslucentColor),
+    G_EACH_BLENDMODE(blend_row),
+};
+
+const GBlendProcs* GBlendProcs_Scalar() { return &gScalarProcs; }
+
+static const GBlendProcs* procs_for(GCpuLevel level) {
+    const GBlendProcs* procs = nullptr;
+    switch (level) {
+        case GCpuLevel::kAVX512: procs = GBlendProcs_AVX512(); break;
+        case GCpuLevel::kAVX2:   procs = GBlendProcs_AVX2();   break;
+        case GCpuLevel::kSSE41:  // nothing here gains from SSE4.1, so it uses the SSE2 procs
+        case GCpuLevel::kSSE2:   procs = GBlendProcs_SSE2();   break;
+        case GCpuLevel::kScalar: break;
+    }
+    return procs ? procs : &gScalarProcs;
+}
+
+static std::atomic<const GBlendProcs*> gProcs{nullptr};     // nullptr until first used
+
+static const GBlendProcs& procs() {
+    const GBlendProcs* procs = gProcs.load(std::memory_order_relaxed);
+    if (!procs) {
+        // if several threads get here at once, they all choose the same set
+        procs = procs_for(GCpu_Level());
+        gProcs.store(procs, std::memory_order_relaxed);
+    }
+    return *procs;
+}
+
+void GBlend_ResetProcs() {
+    gProcs.store(nullptr, std::memory_order_relaxed);
+}
+
+GBlendColorProc GChooseBlendColorProc(GBlendMode mode, GPixel src) {
+    const GBlendProcs& set = procs();
+    const int index = static_cast<int>(mode);
+    assert(index >= 0 && index < GARRAY_COUNT(set.fRow));
+    return GPixel_GetA(src) == 0xFF ? set.fOpaqueColor[index] : set.fTranslucentColor[index];
+}
+
+GBlendRowProc GChooseBlendRowProc(GBlendMode mode) {
+    const GBlendProcs& set = procs();
+    const int index = static_cast<int>(mode);
+    assert(index >= 0 && index < GARRAY_COUNT(set.fRow));
+    return set.fRow[index];
+}
+
+// Always the scalar code, so it can serve as the reference for the other sets.
+GPixel GBlendPixel(GBlendMode mode, GPixel src, GPixel dst) {
+    gScalarProcs.fRow[static_cast<int>(mode)](&dst, &src, 1);
+    return dst;
+}
@@ -0,0 +1,84 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GBlend_DEFINED
+#define GBlend_DEFINED
+
+#include "../include/GBlendMode.h"
+#include "../include/GPixel.h"
+
+// Returns (a * b + 127) / 255, exactly, for a, b in [0 ... 255]
+static inline unsigned GMulDiv255(unsigned a, unsigned b) {
+    unsigned prod = a * b + 128;
+    return (prod + (prod >> 8)) >> 8;
+}
+
+/**
+ *  Where the src pixels come from. Knowing this when the proc is chosen lets each
+ *  (mode x kind) pair be compiled separately, with no per-pixel switch.
+ */
+enum class GSrcKind {
+    kOpaqueColor,       // one src pixel, alpha == 0xFF
+    kTranslucentColor,  // one src pixel, any alpha
+    kShaderRow,         // a row of src pixels (e.g. from GShader::shadeRow)
+};
+
+// Blend a row of dst with a single src pixel
+typedef void (*GBlendColorProc)(GPixel dst[], GPixel src, int count);
+
+// Blend a row of dst with a row of src pixels
+typedef void (*GBlendRowProc)(GPixel dst[], const GPixel src[], int count);
+
+/**
+ *  The procs below come from the set for GCpu_Level(), chosen on first use (and again after
+ *  GBlend_ResetProcs()).
+ *
+ *  Return the proc for this mode and src color. If src is opaque, this returns the
+ *  kOpaqueColor variant (which never reads the src alpha).
+ */
+GBlendColorProc GChooseBlendColorProc(GBlendMode, GPixel src);
+
+GBlendRowProc GChooseBlendRowProc(GBlendMode);
+
+// Called by GCpu_SetLevel(), so the next choice is made from the set for the new level.
+void GBlend_ResetProcs();
+
+/**
+ *  Blend a single pixel, using the formulas in GBlendMode.h. Each product is rounded with
+ *  GMulDiv255(), and the procs above produce exactly these results.
+ */
+GPixel GBlendPixel(GBlendMode, GPixel src, GPixel dst);
+
+/**
+ *  A complete set of procs for one instruction set, indexed by GBlendMode. Every set produces
+ *  the same pixels as GBlendPixel(), bit for bit.
+ */
+struct GBlendProcs {
+    GBlendColorProc fOpaqueColor[12];
+    GBlendColorProc fTranslucentColor[12];
+    GBlendRowProc   fRow[12];
+};
+
+// These return nullptr if that instruction set was not compiled in (e.g. not an x86 build).
+const GBlendProcs* GBlendProcs_Scalar();
+const GBlendProcs* GBlendProcs_SSE2();
+const GBlendProcs* GBlendProcs_AVX2();
+const GBlendProcs* GBlendProcs_AVX512();
+
+// Fills an array initializer with PROC<mode, ...> for each mode, in GBlendMode order
+#define G_EACH_BLENDMODE(PROC, ...)                                         \
+    { PROC<GBlendMode::kClear,   ##__VA_ARGS__>,                            \
+      PROC<GBlendMode::kSrc,     ##__VA_ARGS__>,                            \
+      PROC<GBlendMode::kDst,     ##__VA_ARGS__>,                            \
+      PROC<GBlendMode::kSrcOver, ##__VA_ARGS__>,                            \
+      PROC<GBlendMode::kDstOver, ##__VA_ARGS__>,                            \
+      PROC<GBlendMode::kSrcIn,   ##__VA_ARGS__>,                            \
+      PROC<GBlendMode::kDstIn,   ##__VA_ARGS__>,                            \
+      PROC<GBlendMode::kSrcOut,  ##__VA_ARGS__>,                            \
+      PROC<GBlendMode::kDstOut,  ##__VA_ARGS__>,                            \
+      PROC<GBlendMode::kSrcATop, ##__VA_ARGS__>,                            \
+      PROC<GBlendMode::kDstATop, ##__VA_ARGS__>,                            \
+      PROC<GBlendMode::kXor,     ##__VA_ARGS__> }
+
+#endif
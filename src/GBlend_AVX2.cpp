@@ -0,0 +1,69 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GBlend.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+    #pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+    #pragma GCC push_options
+    #pragma GCC target("avx2")
+#endif
+
+#define G_OPTS_NS avx2
+
+namespace G_OPTS_NS {
+
+// 8 pixels per register. lo/hi/pack work within each 128bit half, which is fine
+// since pack(lo(v), hi(v)) == v, and alpha() never crosses a pixel.
+struct V {
+    using T = __m256i;
+    static constexpr int N = 8;
+
+    static T load(const GPixel p[]) { return _mm256_loadu_si256((const __m256i*)p); }
+    static void store(GPixel p[], T v) { _mm256_storeu_si256((__m256i*)p, v); }
+    static T splat(GPixel p) { return _mm256_set1_epi32((int)p); }
+
+    static T lo(T v) { return _mm256_unpacklo_epi8(v, _mm256_setzero_si256()); }
+    static T hi(T v) { return _mm256_unpackhi_epi8(v, _mm256_setzero_si256()); }
+    static T pack(T lo, T hi) { return _mm256_packus_epi16(lo, hi); }
+
+    static T zero() { return _mm256_setzero_si256(); }
+    static T add(T x, T y) { return _mm256_add_epi16(x, y); }
+    static T inv(T x) { return _mm256_sub_epi16(_mm256_set1_epi16(255), x); }
+
+    // p = x*y + 128 fits in 16 bits, and (p + (p >> 8)) >> 8 is GMulDiv255()
+    static T mul255(T x, T y) {
+        const T p = _mm256_add_epi16(_mm256_mullo_epi16(x, y), _mm256_set1_epi16(128));
+        return _mm256_srli_epi16(_mm256_add_epi16(p, _mm256_srli_epi16(p, 8)), 8);
+    }
+
+    static T alpha(T x) {
+        static_assert(GPIXEL_SHIFT_A == 24, "alpha is expected in the top byte");
+        return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(x, 0xFF), 0xFF);
+    }
+};
+
+}  // namespace G_OPTS_NS
+
+#include "GBlend_opts.h"
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#elif defined(__GNUC__)
+    #pragma GCC pop_options
+#endif
+
+const GBlendProcs* GBlendProcs_AVX2() { return &avx2::gProcs; }
+
+#else
+
+const GBlendProcs* GBlendProcs_AVX2() { return nullptr; }
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GBlend.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+    #pragma clang attribute push(__attribute__((target("avx512f,avx512bw"))), apply_to = function)
+#elif defined(__GNUC__)
+    #pragma GCC push_options
+    #pragma GCC target("avx512f,avx512bw")
+#endif
+
+#define G_OPTS_NS avx512
+
+namespace G_OPTS_NS {
+
+// 16 pixels per register. As with AVX2, lo/hi/pack work within each 128bit lane.
+struct V {
+    using T = __m512i;
+    static constexpr int N = 16;
+
+    static T load(const GPixel p[]) { return _mm512_loadu_si512(p); }
+    static void store(GPixel p[], T v) { _mm512_storeu_si512(p, v); }
+    static T splat(GPixel p) { return _mm512_set1_epi32((int)p); }
+
+    static T lo(T v) { return _mm512_unpacklo_epi8(v, _mm512_setzero_si512()); }
+    static T hi(T v) { return _mm512_unpackhi_epi8(v, _mm512_setzero_si512()); }
+    static T pack(T lo, T hi) { return _mm512_packus_epi16(lo, hi); }
+
+    static T zero() { return _mm512_setzero_si512(); }
+    static T add(T x, T y) { return _mm512_add_epi16(x, y); }
+    static T inv(T x) { return _mm512_sub_epi16(_mm512_set1_epi16(255), x); }
+
+    // p = x*y + 128 fits in 16 bits, and (p + (p >> 8)) >> 8 is GMulDiv255()
+    static T mul255(T x, T y) {
+        const T p = _mm512_add_epi16(_mm512_mullo_epi16(x, y), _mm512_set1_epi16(128));
+        return _mm512_srli_epi16(_mm512_add_epi16(p, _mm512_srli_epi16(p, 8)), 8);
+    }
+
+    static T alpha(T x) {
+        static_assert(GPIXEL_SHIFT_A == 24, "alpha is expected in the top byte");
+        return _mm512_shufflehi_epi16(_mm512_shufflelo_epi16(x, 0xFF), 0xFF);
+    }
+};
+
+}  // namespace G_OPTS_NS
+
+#include "GBlend_opts.h"
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#elif defined(__GNUC__)
+    #pragma GCC pop_options
+#endif
+
+const GBlendProcs* GBlendProcs_AVX512() { return &avx512::gProcs; }
+
+#else
+
+const GBlendProcs* GBlendProcs_AVX512() { return nullptr; }
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GBlend.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+    #pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+    #pragma GCC push_options
+    #pragma GCC target("sse2")
+#endif
+
+#define G_OPTS_NS sse2
+
+namespace G_OPTS_NS {
+
+// 4 pixels per register
+struct V {
+    using T = __m128i;
+    static constexpr int N = 4;
+
+    static T load(const GPixel p[]) { return _mm_loadu_si128((const __m128i*)p); }
+    static void store(GPixel p[], T v) { _mm_storeu_si128((__m128i*)p, v); }
+    static T splat(GPixel p) { return _mm_set1_epi32((int)p); }
+
+    static T lo(T v) { return _mm_unpacklo_epi8(v, _mm_setzero_si128()); }
+    static T hi(T v) { return _mm_unpackhi_epi8(v, _mm_setzero_si128()); }
+    static T pack(T lo, T hi) { return _mm_packus_epi16(lo, hi); }
+
+    static T zero() { return _mm_setzero_si128(); }
+    static T add(T x, T y) { return _mm_add_epi16(x, y); }
+    static T inv(T x) { return _mm_sub_epi16(_mm_set1_epi16(255), x); }
+
+    // p = x*y + 128 fits in 16 bits, and (p + (p >> 8)) >> 8 is GMulDiv255()
+    static T mul255(T x, T y) {
+        const T p = _mm_add_epi16(_mm_mullo_epi16(x, y), _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(p, _mm_srli_epi16(p, 8)), 8);
+    }
+
+    static T alpha(T x) {
+        static_assert(GPIXEL_SHIFT_A == 24, "alpha is expected in the top byte");
+        return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xFF), 0xFF);
+    }
+};
+
+}  // namespace G_OPTS_NS
+
+#include "GBlend_opts.h"
+
+#if defined(__clang__)
+    #pragma clang attribute pop
+#elif defined(__GNUC__)
+    #pragma GCC pop_options
+#endif
+
+const GBlendProcs* GBlendProcs_SSE2() { return &sse2::gProcs; }
+
+#else
+
+const GBlendProcs* GBlendProcs_SSE2() { return nullptr; }
+
+#endif
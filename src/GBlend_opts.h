@@ -0,0 +1,139 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+// No include guard: each GBlend_<isa>.cpp includes this once, after it has
+//  - defined G_OPTS_NS, a namespace unique to that instruction set
+//  - turned on code generation for that instruction set
+//  - defined G_OPTS_NS::V, which wraps its registers:
+//
+//      T               the register type, holding N pixels
+//      load/store      N pixels, unaligned
+//      splat(p)        N copies of p
+//      lo/hi(v)        widen half of the pixels to 16bit components; pack(lo, hi) undoes this
+//      zero()          all components 0
+//      add(x, y)       x + y, per 16bit component
+//      inv(x)          255 - x, per 16bit component
+//      mul255(x, y)    GMulDiv255(x, y), per 16bit component
+//      alpha(x)        each pixel's alpha, copied to all 4 of its 16bit components
+//
+// The arithmetic matches GBlend.cpp exactly (same factors, same rounding), so these procs
+// produce the same pixels as the scalar ones.
+
+namespace G_OPTS_NS {
+
+using T = V::T;
+
+// Every mode is  S * fs + D * fd  (see GBlend.cpp)
+enum Factor { kZero, kOne, kSA, kDA, kInvSA, kInvDA };
+
+template <GBlendMode M> constexpr Factor src_factor() {
+    return M == GBlendMode::kSrc     || M == GBlendMode::kSrcOver ? kOne   :
+           M == GBlendMode::kSrcIn   || M == GBlendMode::kSrcATop ? kDA    :
+           M == GBlendMode::kDstOver || M == GBlendMode::kSrcOut  ||
+           M == GBlendMode::kDstATop || M == GBlendMode::kXor     ? kInvDA : kZero;
+}
+
+template <GBlendMode M> constexpr Factor dst_factor() {
+    return M == GBlendMode::kDst     || M == GBlendMode::kDstOver ? kOne   :
+           M == GBlendMode::kDstIn   || M == GBlendMode::kDstATop ? kSA    :
+           M == GBlendMode::kSrcOver || M == GBlendMode::kDstOut  ||
+           M == GBlendMode::kSrcATop || M == GBlendMode::kXor     ? kInvSA : kZero;
+}
+
+// With an opaque src, Sa is the constant 1 and 1 - Sa is the constant 0
+template <GSrcKind K> constexpr Factor fold(Factor f) {
+    return K != GSrcKind::kOpaqueColor ? f :
+           f == kSA    ? kOne  :
+           f == kInvSA ? kZero : f;
+}
+
+template <Factor F> static inline T scale(T x, T sa, T da) {
+    switch (F) {
+        case kZero:  return V::zero();
+        case kOne:   return x;
+        case kSA:    return V::mul255(x, sa);
+        case kDA:    return V::mul255(x, da);
+        case kInvSA: return V::mul255(x, V::inv(sa));
+        case kInvDA: return V::mul255(x, V::inv(da));
+    }
+    return x;
+}
+
+// s, sa, d are widened; the sums cannot overflow 255 for premultiplied inputs
+template <GBlendMode M, GSrcKind K> static inline T blend16(T s, T sa, T d) {
+    constexpr Factor fs = fold<K>(src_factor<M>()),
+                     fd = fold<K>(dst_factor<M>());
+    const T da = V::alpha(d);   // dropped by the compiler when fs does not use it
+    return V::add(scale<fs>(s, sa, da), scale<fd>(d, sa, da));
+}
+
+// Runs fn(dst, src) on each group of N pixels. The last partial group goes through a
+// small buffer, so fn always sees whole registers.
+template <typename Fn> static inline void each_group(GPixel dst[], const GPixel src[], int count,
+                                                     const Fn& fn) {
+    for (; count >= V::N; count -= V::N) {
+        fn(dst, src);
+        dst += V::N;
+        src += V::N;
+    }
+    if (count > 0) {
+        GPixel d[V::N] = {}, s[V::N] = {};
+        memcpy(d, dst, count * sizeof(GPixel));
+        memcpy(s, src, count * sizeof(GPixel));
+        fn(d, s);
+        memcpy(dst, d, count * sizeof(GPixel));
+    }
+}
+
+// One group of dst blended with a single (already widened) src color
+template <GBlendMode M, GSrcKind K> struct ColorGroup {
+    const T fS, fSA;
+
+    void operator()(GPixel dst[], const GPixel[]) const {
+        const T d = V::load(dst);
+        V::store(dst, V::pack(blend16<M, K>(fS, fSA, V::lo(d)),
+                              blend16<M, K>(fS, fSA, V::hi(d))));
+    }
+};
+
+// One group of dst blended with the same number of src pixels
+template <GBlendMode M> struct RowGroup {
+    void operator()(GPixel dst[], const GPixel src[]) const {
+        constexpr GSrcKind K = GSrcKind::kShaderRow;
+        const T d = V::load(dst),
+                s = V::load(src);
+        const T slo = V::lo(s),
+                shi = V::hi(s);
+        V::store(dst, V::pack(blend16<M, K>(slo, V::alpha(slo), V::lo(d)),
+                              blend16<M, K>(shi, V::alpha(shi), V::hi(d))));
+    }
+};
+
+template <GBlendMode M, GSrcKind K> static void blend_color(GPixel dst[], GPixel src, int count) {
+    if (M == GBlendMode::kDst) {
+        return;
+    }
+    if (M == GBlendMode::kClear || M == GBlendMode::kSrc) {
+        const GPixel value = (M == GBlendMode::kSrc) ? src : 0;
+        for (int i = 0; i < count; ++i) {
+            dst[i] = value;
+        }
+        return;
+    }
+    // src is the same in both halves, so it is widened once
+    const T s = V::lo(V::splat(src));
+    each_group(dst, dst, count, ColorGroup<M, K>{s, V::alpha(s)});
+}
+
+template <GBlendMode M> static void blend_row(GPixel dst[], const GPixel src[], int count) {
+    each_group(dst, src, count, RowGroup<M>());
+}
+
+static const GBlendProcs gProcs = {
+    G_EACH_BLENDMODE(blend_color, GSrcKind::kOpaqueColor),
+    G_EACH_BLENDMODE(blend_color, GSrcKind::kTranslucentColor),
+    G_EACH_BLENDMODE(blend_row),
+};
+
+}  // namespace G_OPTS_NS
@@ -0,0 +1,194 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GBlitter.h"
+#include "GBlend.h"
+#include "../include/GArena.h"
+#include "../include/GShader.h"
+#include <algorithm>
+
+// src*a + dst*(255-a), per component. Premul in, premul out.
+static GPixel lerp(GPixel src, GPixel dst, unsigned a) {
+    const unsigned ia = 255 - a;
+    unsigned result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        unsigned s = (src >> shift) & 0xFF,
+                 d = (dst >> shift) & 0xFF;
+        result |= (GMulDiv255(s, a) + GMulDiv255(d, ia)) << shift;
+    }
+    return result;
+}
+
+void GOpaqueStoreBlitter::blitH(int x, int y, int width) {
+    fFill(fBitmap.getAddr(x, y), fSrc, width);
+}
+
+void GOpaqueStoreBlitter::blitRect(int x, int y, int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    GPixel* row = fBitmap.getAddr(x, y);
+    const size_t rowPixels = fBitmap.rowBytes() >> 2;
+    if (rowPixels == (size_t)width) {
+        // the rows are contiguous, so treat them as one long row
+        fFill(row, fSrc, width * height);
+        return;
+    }
+    for (int i = 0; i < height; ++i) {
+        fFill(row, fSrc, width);
+        row += rowPixels;
+    }
+}
+
+void GOpaqueStoreBlitter::blitAntiH(int x, int y, const GAlphaRun runs[]) {
+    GPixel* row = fBitmap.getAddr(0, y);
+    for (; runs->fCount; x += runs->fCount, ++runs) {
+        const unsigned a = runs->fAlpha;
+        if (a == 0xFF) {
+            fFill(row + x, fSrc, runs->fCount);
+        } else if (a > 0) {
+            for (int i = 0; i < runs->fCount; ++i) {
+                row[x + i] = lerp(fSrc, row[x + i], a);
+            }
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Any color, any mode, through the (mode x color-kind) proc that was chosen up front.
+class ColorBlitter : public GBlitter {
+public:
+    ColorBlitter(const GBitmap& bitmap, GBlendMode mode, GPixel src)
+        : fBitmap(bitmap), fProc(GChooseBlendColorProc(mode, src)), fSrc(src) {}
+
+    void blitH(int x, int y, int width) override {
+        fProc(fBitmap.getAddr(x, y), fSrc, width);
+    }
+
+    void blitAntiH(int x, int y, const GAlphaRun runs[]) override {
+        GPixel* row = fBitmap.getAddr(0, y);
+        for (; runs->fCount; x += runs->fCount, ++runs) {
+            const unsigned a = runs->fAlpha;
+            if (a == 0xFF) {
+                fProc(row + x, fSrc, runs->fCount);
+            } else if (a > 0) {
+                for (int i = 0; i < runs->fCount; ++i) {
+                    GPixel result = row[x + i];
+                    fProc(&result, fSrc, 1);
+                    row[x + i] = lerp(result, row[x + i], a);
+                }
+            }
+        }
+    }
+
+private:
+    const GBitmap         fBitmap;
+    const GBlendColorProc fProc;
+    const GPixel          fSrc;
+};
+
+// Shades into a small buffer, and blends each chunk while it is still in cache.
+constexpr int kChunk = 256;
+
+class ShaderBlitter : public GBlitter {
+public:
+    ShaderBlitter(const GBitmap& bitmap, GBlendMode mode, GShader* shader)
+        : fBitmap(bitmap), fProc(GChooseBlendRowProc(mode)), fShader(shader) {}
+
+    void blitH(int x, int y, int width) override {
+        GPixel* dst = fBitmap.getAddr(x, y);
+        while (width > 0) {
+            const int n = std::min(width, kChunk);
+            fShader->shadeRow(x, y, n, fStorage);
+            fProc(dst, fStorage, n);
+            x += n;
+            dst += n;
+            width -= n;
+        }
+    }
+
+    void blitAntiH(int x, int y, const GAlphaRun runs[]) override {
+        GPixel* row = fBitmap.getAddr(0, y);
+        for (; runs->fCount; x += runs->fCount, ++runs) {
+            const unsigned a = runs->fAlpha;
+            if (a == 0xFF) {
+                this->blitH(x, y, runs->fCount);
+            } else if (a > 0) {
+                // blend a chunk into a copy of the dst, then lerp the copy back by the coverage
+                for (int i = 0; i < runs->fCount; i += kChunk) {
+                    const int n = std::min(runs->fCount - i, kChunk);
+                    GPixel* dst = row + x + i;
+                    fShader->shadeRow(x + i, y, n, fStorage);
+                    std::copy(dst, dst + n, fBlended);
+                    fProc(fBlended, fStorage, n);
+                    for (int j = 0; j < n; ++j) {
+                        dst[j] = lerp(fBlended[j], dst[j], a);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    const GBitmap       fBitmap;
+    const GBlendRowProc fProc;
+    GShader*            fShader;
+    GPixel              fStorage[kChunk];
+    GPixel              fBlended[kChunk];
+};
+
+// kSrc, or kSrcOver with an opaque shader: the result is the shader's colors, so the shader
+// writes them straight into the dst, with no buffer and no blend pass.
+class ShaderStoreBlitter : public GBlitter {
+public:
+    ShaderStoreBlitter(const GBitmap& bitmap, GShader* shader)
+        : fBitmap(bitmap), fShader(shader) {}
+
+    void blitH(int x, int y, int width) override {
+        fShader->shadeRow(x, y, width, fBitmap.getAddr(x, y));
+    }
+
+    void blitAntiH(int x, int y, const GAlphaRun runs[]) override {
+        GPixel* row = fBitmap.getAddr(0, y);
+        for (; runs->fCount; x += runs->fCount, ++runs) {
+            const unsigned a = runs->fAlpha;
+            if (a == 0xFF) {
+                this->blitH(x, y, runs->fCount);
+            } else if (a > 0) {
+                for (int i = 0; i < runs->fCount; i += kChunk) {
+                    const int n = std::min(runs->fCount - i, kChunk);
+                    GPixel* dst = row + x + i;
+                    fShader->shadeRow(x + i, y, n, fStorage);
+                    for (int j = 0; j < n; ++j) {
+                        dst[j] = lerp(fStorage[j], dst[j], a);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    const GBitmap fBitmap;
+    GShader*      fShader;
+    GPixel        fStorage[kChunk];     // only for partial coverage
+};
+
+}  // namespace
+
+GBlitter* GChooseBlitter(const GBitmap& bitmap, GBlendMode mode, GPixel src, GShader* shader,
+                         GArena* arena) {
+    if (shader) {
+        if (mode == GBlendMode::kSrc || (mode == GBlendMode::kSrcOver && shader->isOpaque())) {
+            return arena->make<ShaderStoreBlitter>(bitmap, shader);
+        }
+        return arena->make<ShaderBlitter>(bitmap, mode, shader);
+    }
+    if (GPixel_GetA(src) == 0xFF && (mode == GBlendMode::kSrc || mode == GBlendMode::kSrcOver)) {
+        return arena->make<GOpaqueStoreBlitter>(bitmap, src);
+    }
+    return arena->make<ColorBlitter>(bitmap, mode, src);
+}
@@ -0,0 +1,82 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GBlitter_DEFINED
+#define GBlitter_DEFINED
+
+#include "../include/GBitmap.h"
+#include "../include/GBlendMode.h"
+#include "GBlend.h"
+
+class GArena;
+class GShader;
+
+/**
+ *  One run of constant coverage in a row, for GBlitter::blitAntiH().
+ *  An array of runs is terminated by a run with fCount == 0.
+ */
+struct GAlphaRun {
+    uint16_t fCount;
+    uint8_t  fAlpha;    // 0 means not covered, 0xFF means fully covered
+};
+
+/**
+ *  The scan converters (rects, polygons, paths) produce spans; a blitter turns those spans
+ *  into pixels. A draw chooses its blitter once, after looking at the paint, so the per-span
+ *  calls do not re-examine the paint.
+ *
+ *  All coordinates are in device space, and have already been clipped to the bitmap.
+ */
+class GBlitter {
+public:
+    virtual ~GBlitter() {}
+
+    // Fully cover [x ... x + width) on row y
+    virtual void blitH(int x, int y, int width) = 0;
+
+    // Fully cover [x ... x + width) x [y ... y + height)
+    virtual void blitRect(int x, int y, int width, int height) {
+        for (int i = 0; i < height; ++i) {
+            this->blitH(x, y + i, width);
+        }
+    }
+
+    // Cover row y, starting at x, with the coverage described by runs[]
+    virtual void blitAntiH(int x, int y, const GAlphaRun runs[]) = 0;
+};
+
+/**
+ *  Blitter for opaque sources that replace the dst (e.g. an opaque color with kSrc or
+ *  kSrcOver). Full coverage is a plain store of whole rows; partial coverage is a lerp.
+ */
+class GOpaqueStoreBlitter : public GBlitter {
+public:
+    GOpaqueStoreBlitter(const GBitmap& bitmap, GPixel src)
+        : fBitmap(bitmap), fFill(GChooseBlendColorProc(GBlendMode::kSrc, src)), fSrc(src) {
+        assert(GPixel_GetA(src) == 0xFF);
+    }
+
+    void blitH(int x, int y, int width) override;
+    void blitRect(int x, int y, int width, int height) override;
+    void blitAntiH(int x, int y, const GAlphaRun runs[]) override;
+
+private:
+    const GBitmap         fBitmap;
+    const GBlendColorProc fFill;    // kSrc stores src, using the widest stores the cpu has
+    const GPixel          fSrc;
+};
+
+/**
+ *  Return the most specialized blitter for drawing src (or shader, if not null) into the
+ *  bitmap with this mode. The blitter is allocated in the arena.
+ *
+ *  Shaders drawn with kSrc (or with kSrcOver, if the shader is opaque) shade straight into the
+ *  dst rows. Other modes shade a chunk of a row into a small buffer, and blend it into the dst
+ *  while it is still in cache.
+ *
+ *  src must be premultiplied. If there is a shader, its context must already be set.
+ */
+GBlitter* GChooseBlitter(const GBitmap&, GBlendMode, GPixel src, GShader* shader, GArena*);
+
+#endif
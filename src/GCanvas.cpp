@@ -0,0 +1,12 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "../include/GCanvas.h"
+#include "../include/GPathBuilder.h"
+
+void GCanvas::clipRect(const GRect& rect) {
+    GPathBuilder bu;
+    bu.addRect(rect);
+    this->clipPath(*bu.detach());
+}
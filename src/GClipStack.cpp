@@ -0,0 +1,220 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GClipStack.h"
+#include "GBlitter.h"
+#include "GEdge.h"
+#include "../include/GArena.h"
+#include "../include/GPath.h"
+#include <algorithm>
+
+struct GClipStack::Mask {
+    GIRect               fArea;
+    std::vector<uint8_t> fCoverage;     // fArea.width() bytes per row
+
+    // Clear it to cover area, keeping the storage if it is big enough
+    void reset(const GIRect& area) {
+        fArea = area;
+        fCoverage.assign((size_t)area.width() * area.height(), 0);
+    }
+
+    uint8_t* addr(int x, int y) {
+        return &fCoverage[(size_t)(y - fArea.top) * fArea.width() + (x - fArea.left)];
+    }
+    uint8_t at(int x, int y) const {
+        return fCoverage[(size_t)(y - fArea.top) * fArea.width() + (x - fArea.left)];
+    }
+};
+
+static GIRect intersect(const GIRect& a, const GIRect& b) {
+    GIRect r = GIRect::LTRB(std::max(a.left, b.left), std::max(a.top, b.top),
+                            std::min(a.right, b.right), std::min(a.bottom, b.bottom));
+    return r.isEmpty() ? GIRect::LTRB(0, 0, 0, 0) : r;
+}
+
+// Maps rects to rects: scale + translate, possibly swapping x and y (e.g. rotate 90)
+static bool preserves_rects(const GMatrix& m) {
+    return (m[1] == 0 && m[2] == 0) || (m[0] == 0 && m[3] == 0);
+}
+
+GClipStack::GClipStack(int width, int height)
+    : fWidth(width), fState{GIRect::WH(width, height), nullptr} {}
+
+GClipStack::~GClipStack() {}
+
+void GClipStack::save() {
+    fSaved.push_back(fState);
+}
+
+void GClipStack::restore() {
+    assert(!fSaved.empty());
+    fState = fSaved.back();
+    fSaved.pop_back();
+}
+
+void GClipStack::clipRect(const GRect& r, const GMatrix& ctm) {
+    GPoint pts[4] = {{r.left, r.top}, {r.right, r.top}, {r.right, r.bottom}, {r.left, r.bottom}};
+    ctm.mapPoints(pts, 4);
+    const GRect dev = GRect::LTRB(std::min({pts[0].x, pts[1].x, pts[2].x, pts[3].x}),
+                                  std::min({pts[0].y, pts[1].y, pts[2].y, pts[3].y}),
+                                  std::max({pts[0].x, pts[1].x, pts[2].x, pts[3].x}),
+                                  std::max({pts[0].y, pts[1].y, pts[2].y, pts[3].y}));
+    if (preserves_rects(ctm)) {
+        // Just shrink the bounds. If there is a mask, it still covers them.
+        fState.fBounds = intersect(fState.fBounds, dev.round());
+        if (fState.fBounds.isEmpty()) {
+            fState.fMask = nullptr;
+        }
+        return;
+    }
+    GEdge edges[4 * GEdge::kMaxPerLine];
+    int count = 0;
+    for (int i = 0; i < 4; ++i) {
+        count += GEdge::SetLine(pts[i], pts[(i + 1) & 3], edges + count);
+    }
+    this->intersectEdges(edges, count, dev);
+}
+
+void GClipStack::clipPath(const GPath& path, const GMatrix& ctm) {
+    const int maxCount = GMaxEdgeCount(path);
+    if ((int)fEdges.size() < maxCount) {
+        fEdges.resize(maxCount);
+    }
+    GRect dev;
+    const int count = GBuildEdges(path, ctm, fEdges.data(), &dev);
+    this->intersectEdges(fEdges.data(), count, dev);
+}
+
+// Sets the pixels of the spans in a new mask, where the previous mask (if any) also has them
+class GClipStack::MaskWriter : public GBlitter {
+public:
+    MaskWriter(Mask* mask, const Mask* prev)
+        : fMask(mask), fPrev(prev), fTight(GIRect::LTRB(0, 0, 0, 0)) {}
+
+    // The bounds of the pixels that were set
+    GIRect tight() const { return fTight; }
+
+    void blitH(int x, int y, int width) override {
+        int L = x + width, R = x;
+        for (int i = x; i < x + width; ++i) {
+            if (!fPrev || fPrev->at(i, y)) {
+                *fMask->addr(i, y) = 0xFF;
+                L = std::min(L, i);
+                R = i + 1;
+            }
+        }
+        if (L < R) {
+            fTight = fTight.isEmpty() ? GIRect::LTRB(L, y, R, y + 1)
+                                      : GIRect::LTRB(std::min(fTight.left, L), fTight.top,
+                                                     std::max(fTight.right, R), y + 1);
+        }
+    }
+
+    void blitAntiH(int x, int y, const GAlphaRun runs[]) override {
+        assert(false);  // clips are sampled at pixel centers, so they only have whole spans
+    }
+
+private:
+    Mask* const       fMask;
+    const Mask* const fPrev;
+    GIRect            fTight;
+};
+
+/*
+ *  Scan converts the edges into a new mask, limited to the current clip.
+ */
+void GClipStack::intersectEdges(GEdge edges[], int count, const GRect& devBounds) {
+    const GIRect area = intersect(fState.fBounds, devBounds.roundOut());
+    if (area.isEmpty()) {
+        fState = { area, nullptr };
+        return;
+    }
+
+    std::shared_ptr<Mask> mask = this->newMask(area);
+    MaskWriter writer(mask.get(), fState.fMask.get());
+    fScan.fill(edges, count, area, &writer);
+
+    const GIRect tight = writer.tight();
+    bool allCovered = true;
+    for (int y = tight.top; y < tight.bottom && allCovered; ++y) {
+        for (int x = tight.left; x < tight.right; ++x) {
+            allCovered &= mask->at(x, y) != 0;
+        }
+    }
+    // e.g. a rect rotated by a multiple of 90 degrees: no mask needed after all
+    fState = { tight, (allCovered || tight.isEmpty()) ? nullptr : std::move(mask) };
+}
+
+std::shared_ptr<GClipStack::Mask> GClipStack::newMask(const GIRect& area) {
+    for (const auto& mask : fMasks) {
+        if (mask.use_count() == 1) {    // no state has it
+            mask->reset(area);
+            return mask;
+        }
+    }
+    fMasks.push_back(std::make_shared<Mask>());
+    fMasks.back()->reset(area);
+    return fMasks.back();
+}
+
+uint8_t GClipStack::coverage(int x, int y) const {
+    assert(fState.fMask);
+    return fState.fMask->at(x, y);
+}
+
+namespace {
+
+// Passes on only the parts of each span that are in the mask
+class MaskBlitter : public GBlitter {
+public:
+    MaskBlitter(GBlitter* blitter, const GClipStack* clip, GAlphaRun runs[])
+        : fBlitter(blitter), fClip(clip), fRuns(runs) {}
+
+    void blitH(int x, int y, int width) override {
+        const int stop = x + width;
+        while (x < stop) {
+            for (; x < stop && !fClip->coverage(x, y); ++x) {}
+            const int start = x;
+            for (; x < stop && fClip->coverage(x, y); ++x) {}
+            if (x > start) {
+                fBlitter->blitH(start, y, x - start);
+            }
+        }
+    }
+
+    void blitAntiH(int x, int y, const GAlphaRun runs[]) override {
+        GAlphaRun* out = fRuns;
+        out->fCount = 0;
+        for (int px = x; runs->fCount; ++runs) {
+            for (int i = 0; i < runs->fCount; ++i, ++px) {
+                const uint8_t alpha = fClip->coverage(px, y) ? runs->fAlpha : 0;
+                if (out->fCount > 0 && out->fAlpha != alpha) {
+                    ++out;
+                    out->fCount = 0;
+                }
+                out->fAlpha = alpha;
+                out->fCount += 1;
+            }
+        }
+        if (out->fCount > 0) {
+            ++out;
+        }
+        out->fCount = 0;
+        fBlitter->blitAntiH(x, y, fRuns);
+    }
+
+private:
+    GBlitter*         fBlitter;
+    const GClipStack* fClip;
+    GAlphaRun*        fRuns;    // room for one run per pixel in a row, plus the terminator
+};
+
+}  // namespace
+
+GBlitter* GClipStack::clipBlitter(GBlitter* blitter, GArena* arena) const {
+    if (this->isRect()) {
+        return blitter;
+    }
+    return arena->make<MaskBlitter>(blitter, this, arena->makeArray<GAlphaRun>(fWidth + 1));
+}
@@ -0,0 +1,83 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GClipStack_DEFINED
+#define GClipStack_DEFINED
+
+#include "GScanConverter.h"
+#include "../include/GMatrix.h"
+#include "../include/GRect.h"
+#include <memory>
+#include <vector>
+
+class GArena;
+class GBlitter;
+class GPath;
+
+/**
+ *  The clip half of a canvas' save/restore state, in device space.
+ *
+ *  A clip is its device bounds, plus (only if some clip was not a device-aligned rectangle)
+ *  a mask with one byte per pixel (0 or 0xFF). Scan converters clip their spans to bounds()
+ *  instead of to the bitmap, so rectangular clips cost nothing; if there is a mask, they also
+ *  wrap their blitter with clipBlitter().
+ *
+ *  Pixels are in the clip if their centers are, the same rule as the draws.
+ *
+ *  The stack keeps every mask it has made, and reuses one once no saved state refers to it, so
+ *  a canvas that clips the same way every frame stops allocating after the first.
+ */
+class GClipStack {
+public:
+    GClipStack(int width, int height);
+    ~GClipStack();
+
+    void save();
+    void restore();
+
+    // Intersect the clip with the rect or path (winding fill), each mapped by ctm
+    void clipRect(const GRect&, const GMatrix& ctm);
+    void clipPath(const GPath&, const GMatrix& ctm);
+
+    // No pixel outside of these bounds is in the clip. Always inside the bitmap.
+    GIRect bounds() const { return fState.fBounds; }
+
+    bool isEmpty() const { return fState.fBounds.isEmpty(); }
+
+    // True if every pixel in bounds() is in the clip (i.e. there is no mask)
+    bool isRect() const { return fState.fMask == nullptr; }
+
+    // If !isRect(), the coverage (0 or 0xFF) of pixel (x, y), which must be inside bounds()
+    uint8_t coverage(int x, int y) const;
+
+    /**
+     *  Return a blitter that only writes the pixels of blitter's spans that are in the clip.
+     *  If isRect(), this is blitter itself (its spans are already inside bounds()); otherwise
+     *  the wrapper is allocated in the arena, and must not outlive this clip.
+     */
+    GBlitter* clipBlitter(GBlitter* blitter, GArena*) const;
+
+private:
+    struct Mask;
+    class MaskWriter;
+
+    struct State {
+        GIRect                      fBounds;
+        std::shared_ptr<const Mask> fMask;  // shared by the saved states, never modified
+    };
+
+    // Intersect the clip with the edges (winding fill), whose device bounds are devBounds
+    void intersectEdges(GEdge edges[], int count, const GRect& devBounds);
+    // Return an empty mask of area, from fMasks if one is not in use
+    std::shared_ptr<Mask> newMask(const GIRect& area);
+
+    const int                          fWidth;
+    State                              fState;
+    std::vector<State>                 fSaved;
+    GScanConverter                     fScan;
+    std::vector<GEdge>                 fEdges;     // scratch, for clipPath()
+    std::vector<std::shared_ptr<Mask>> fMasks;     // every mask made, for newMask()
+};
+
+#endif
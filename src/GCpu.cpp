@@ -0,0 +1,85 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GCpu.h"
+#include "GBlend.h"
+#include "../include/GTypes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* gNames[] = { "scalar", "sse2", "sse41", "avx2", "avx512" };
+
+GCpuLevel GCpu_Detect() {
+#if defined(__x86_64__) || defined(__i386__)
+    // these read cpuid (and check that the OS saves the wide registers)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        return GCpuLevel::kAVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return GCpuLevel::kAVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return GCpuLevel::kSSE41;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return GCpuLevel::kSSE2;
+    }
+#endif
+    return GCpuLevel::kScalar;
+}
+
+static GCpuLevel clamp_to_cpu(GCpuLevel level) {
+    static const GCpuLevel gDetected = GCpu_Detect();
+    return std::min(level, gDetected);
+}
+
+static GCpuLevel initial_level() {
+    GCpuLevel level = GCpuLevel::kAVX512;
+    if (const char* name = getenv("G_CPU_LEVEL")) {
+        if (!GCpu_ParseName(name, &level)) {
+            // don't let a typo quietly test (or time) some other level
+            fprintf(stderr, "G_CPU_LEVEL: unknown cpu level %s, using %s\n",
+                    name, GCpu_Name(GCpu_Detect()));
+        }
+    }
+    return clamp_to_cpu(level);
+}
+
+static std::atomic<int> gLevel{-1};     // -1 until first used
+
+GCpuLevel GCpu_Level() {
+    int level = gLevel.load(std::memory_order_relaxed);
+    if (level < 0) {
+        // if several threads get here at once, they all compute the same answer
+        level = static_cast<int>(initial_level());
+        gLevel.store(level, std::memory_order_relaxed);
+    }
+    return static_cast<GCpuLevel>(level);
+}
+
+GCpuLevel GCpu_SetLevel(GCpuLevel level) {
+    level = clamp_to_cpu(level);
+    gLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+    GBlend_ResetProcs();
+    return level;
+}
+
+const char* GCpu_Name(GCpuLevel level) {
+    return gNames[static_cast<int>(level)];
+}
+
+bool GCpu_ParseName(const char name[], GCpuLevel* level) {
+    for (int i = 0; i < GARRAY_COUNT(gNames); ++i) {
+        if (!strcmp(name, gNames[i])) {
+            *level = static_cast<GCpuLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
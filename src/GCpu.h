@@ -0,0 +1,45 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GCpu_DEFINED
+#define GCpu_DEFINED
+
+/**
+ *  Instruction set levels that the pixel procs (e.g. GBlend.h) are specialized for.
+ *  Each level includes the ones before it.
+ */
+enum class GCpuLevel {
+    kScalar,    // plain C++, for any cpu
+    kSSE2,
+    kSSE41,
+    kAVX2,
+    kAVX512,    // AVX-512 F + BW
+};
+
+/**
+ *  Return the highest level this cpu supports (read with cpuid), and that this build has
+ *  procs for. On non-x86 builds this is always kScalar.
+ */
+GCpuLevel GCpu_Detect();
+
+/**
+ *  Return the level the procs are chosen for. On first use this is GCpu_Detect(), unless the
+ *  environment variable G_CPU_LEVEL names a level (see GCpu_Name()), in which case it is that
+ *  level, clamped to GCpu_Detect(). An unknown name is reported on stderr, and ignored.
+ */
+GCpuLevel GCpu_Level();
+
+/**
+ *  Force the level (e.g. to test every level on one machine), clamped to GCpu_Detect().
+ *  Draws that have already chosen their procs are not affected. Returns the new level.
+ */
+GCpuLevel GCpu_SetLevel(GCpuLevel);
+
+// "scalar", "sse2", "sse41", "avx2", "avx512"
+const char* GCpu_Name(GCpuLevel);
+
+// Returns false if name is not one of the names above.
+bool GCpu_ParseName(const char name[], GCpuLevel* level);
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GDeferredClear.h"
+#include "GBlend.h"
+#include <algorithm>
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+// Pending areas at least this large are streamed at flush() (about the size of an L2 cache)
+constexpr size_t kStreamBytes = 1 << 20;
+
+void GStreamFill(GPixel dst[], size_t count, GPixel value) {
+#if defined(__SSE2__)
+    // stream stores must be 16-byte aligned
+    for (; count > 0 && ((uintptr_t)dst & 15); --count) {
+        *dst++ = value;
+    }
+    const __m128i v = _mm_set1_epi32((int)value);
+    for (; count >= 4; count -= 4) {
+        _mm_stream_si128((__m128i*)dst, v);
+        dst += 4;
+    }
+    _mm_sfence();   // make the streamed pixels visible before anyone reads them
+#endif
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = value;
+    }
+}
+
+GDeferredClear::GDeferredClear(const GBitmap& bitmap)
+    : fBitmap(bitmap)
+    , fPending((bitmap.height() + kBandRows - 1) / kBandRows, false) {}
+
+void GDeferredClear::clear(GPixel p) {
+    std::fill(fPending.begin(), fPending.end(), true);
+    fPendingCount = (int)fPending.size();
+    fColor = p;
+}
+
+void GDeferredClear::willDraw(int top, int bottom) {
+    if (fPendingCount == 0) {
+        return;
+    }
+    const int start = std::max(top, 0) / kBandRows,
+              end = std::min((bottom + kBandRows - 1) / kBandRows, (int)fPending.size());
+    this->fillBands(start, end, false);
+}
+
+void GDeferredClear::flush() {
+    if (fPendingCount == 0) {
+        return;
+    }
+    const size_t bytes = (size_t)fPendingCount * kBandRows * fBitmap.rowBytes();
+    this->fillBands(0, (int)fPending.size(), bytes >= kStreamBytes);
+}
+
+// Fills each run of consecutive pending bands in [start, end)
+void GDeferredClear::fillBands(int start, int end, bool stream) {
+    const int width = fBitmap.width(),
+              height = fBitmap.height();
+    const size_t rowPixels = fBitmap.rowBytes() >> 2;
+    const auto fill = GChooseBlendColorProc(GBlendMode::kSrc, fColor);
+
+    for (int band = start; band < end;) {
+        if (!fPending[band]) {
+            band += 1;
+            continue;
+        }
+        int runEnd = band;
+        for (; runEnd < end && fPending[runEnd]; ++runEnd) {
+            fPending[runEnd] = false;
+            fPendingCount -= 1;
+        }
+        const int y0 = band * kBandRows,
+                  y1 = std::min(runEnd * kBandRows, height);
+        GPixel* row = fBitmap.getAddr(0, y0);
+        if (rowPixels == (size_t)width) {
+            // the rows are contiguous, so treat them as one long row
+            const size_t count = (size_t)width * (y1 - y0);
+            if (stream) {
+                GStreamFill(row, count, fColor);
+            } else {
+                fill(row, fColor, (int)count);
+            }
+        } else {
+            for (int y = y0; y < y1; ++y, row += rowPixels) {
+                if (stream) {
+                    GStreamFill(row, width, fColor);
+                } else {
+                    fill(row, fColor, width);
+                }
+            }
+        }
+        band = runEnd;
+    }
+}
@@ -0,0 +1,51 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GDeferredClear_DEFINED
+#define GDeferredClear_DEFINED
+
+#include "../include/GBitmap.h"
+#include <vector>
+
+/**
+ *  Defers GCanvas::clear(). The canvas records the color here, and before each draw asks for
+ *  the rows it will touch; only bands of those rows that are still pending get written, right
+ *  before the draw reads them. flush() writes whatever is left, with non-temporal stores when
+ *  there is a lot of it (those pixels will not be read again soon).
+ *
+ *  Consecutive clears cost nothing: the last color wins.
+ */
+class GDeferredClear {
+public:
+    enum { kBandRows = 16 };
+
+    GDeferredClear(const GBitmap&);
+
+    // Every pixel is to become p
+    void clear(GPixel p);
+
+    // Rows [top, bottom) are about to be read or written
+    void willDraw(int top, int bottom);
+
+    // Write every pixel that is still pending
+    void flush();
+
+    bool hasPending() const { return fPendingCount > 0; }
+
+private:
+    void fillBands(int start, int end, bool stream);
+
+    const GBitmap     fBitmap;
+    std::vector<bool> fPending;     // one per band
+    int               fPendingCount = 0;
+    GPixel            fColor = 0;
+};
+
+/**
+ *  Sets count pixels to value, with non-temporal (cache bypassing) stores where the cpu has
+ *  them. Only worth it for fills much larger than the cache.
+ */
+void GStreamFill(GPixel dst[], size_t count, GPixel value);
+
+#endif
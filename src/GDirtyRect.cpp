@@ -0,0 +1,27 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GDirtyRect.h"
+#include <algorithm>
+
+void GDirtyRect::join(const GIRect& r) {
+    const GIRect clipped = GIRect::LTRB(std::max(r.left, 0), std::max(r.top, 0),
+                                        std::min(r.right, fWidth), std::min(r.bottom, fHeight));
+    if (clipped.isEmpty()) {
+        return;
+    }
+    if (fDirty.isEmpty()) {
+        fDirty = clipped;
+        return;
+    }
+    fDirty = GIRect::LTRB(std::min(fDirty.left, clipped.left), std::min(fDirty.top, clipped.top),
+                          std::max(fDirty.right, clipped.right),
+                          std::max(fDirty.bottom, clipped.bottom));
+}
+
+GIRect GDirtyRect::take() {
+    const GIRect dirty = fDirty;
+    fDirty = GIRect::LTRB(0, 0, 0, 0);
+    return dirty;
+}
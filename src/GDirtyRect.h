@@ -0,0 +1,36 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GDirtyRect_DEFINED
+#define GDirtyRect_DEFINED
+
+#include "../include/GRect.h"
+
+/**
+ *  The union of the device bounds a canvas has drawn into since it was last asked, for
+ *  GCanvas::takeDirtyRect(). The canvas joins the (clipped) bounds of each draw, and all of
+ *  the bitmap for clear(). A window then only needs to copy that rect to the screen.
+ */
+class GDirtyRect {
+public:
+    GDirtyRect(int width, int height)
+        : fWidth(width), fHeight(height), fDirty(GIRect::LTRB(0, 0, 0, 0)) {}
+
+    // The pixels in r (which need not be inside the bitmap) may have changed
+    void join(const GIRect& r);
+
+    // Every pixel may have changed
+    void joinAll() { fDirty = GIRect::WH(fWidth, fHeight); }
+
+    bool isEmpty() const { return fDirty.isEmpty(); }
+
+    // Return the dirty rect (inside the bitmap, empty if nothing changed), and start over
+    GIRect take();
+
+private:
+    const int fWidth, fHeight;
+    GIRect    fDirty;
+};
+
+#endif
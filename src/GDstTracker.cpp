@@ -0,0 +1,71 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GDstTracker.h"
+#include <algorithm>
+
+void GDstTracker::clear(GPixel p) {
+    std::fill(fBands.begin(), fBands.end(), GDstState::Constant(p));
+}
+
+void GDstTracker::reset() {
+    std::fill(fBands.begin(), fBands.end(), GDstState::Unknown());
+}
+
+static int first_band(int top) {
+    return std::max(top, 0) / GDstTracker::kBandRows;
+}
+
+static int end_band(int bottom, int bandCount) {
+    return std::min((bottom + GDstTracker::kBandRows - 1) / GDstTracker::kBandRows, bandCount);
+}
+
+GDstState GDstTracker::query(int top, int bottom) const {
+    const int start = first_band(top),
+              end = end_band(bottom, (int)fBands.size());
+    if (start >= end) {
+        return GDstState::Unknown();
+    }
+    GDstState state = fBands[start];
+    for (int i = start + 1; i < end && state.fKind != GDstState::kUnknown; ++i) {
+        const GDstState& band = fBands[i];
+        if (state.fKind == GDstState::kConstant && band.fKind == GDstState::kConstant &&
+            state.fPixel == band.fPixel) {
+            continue;
+        }
+        state = (state.isOpaque() && band.isOpaque()) ? GDstState::Opaque()
+                                                      : GDstState::Unknown();
+    }
+    return state;
+}
+
+/*
+ *  With Da == 1, these modes leave Da == 1 (e.g. SrcOver: Sa + (1 - Sa)), as does a partially
+ *  covered pixel, since it is a lerp between two opaque pixels.
+ */
+static bool keeps_opaque(GBlendMode mode, bool srcIsOpaque) {
+    switch (mode) {
+        case GBlendMode::kDst:
+        case GBlendMode::kSrcOver:
+        case GBlendMode::kDstOver:
+        case GBlendMode::kSrcATop:
+            return true;
+        case GBlendMode::kSrc:
+        case GBlendMode::kSrcIn:
+        case GBlendMode::kDstIn:
+        case GBlendMode::kDstATop:
+            return srcIsOpaque;
+        default:
+            return false;
+    }
+}
+
+void GDstTracker::didDraw(int top, int bottom, GBlendMode mode, bool srcIsOpaque) {
+    const int end = end_band(bottom, (int)fBands.size());
+    for (int i = first_band(top); i < end; ++i) {
+        GDstState& band = fBands[i];
+        band = (band.isOpaque() && keeps_opaque(mode, srcIsOpaque)) ? GDstState::Opaque()
+                                                                    : GDstState::Unknown();
+    }
+}
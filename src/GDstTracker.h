@@ -0,0 +1,63 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GDstTracker_DEFINED
+#define GDstTracker_DEFINED
+
+#include "../include/GBlendMode.h"
+#include "../include/GPixel.h"
+#include <vector>
+
+/**
+ *  What is known about some dst pixels, before a draw reads them.
+ */
+struct GDstState {
+    enum Kind {
+        kUnknown,
+        kOpaque,    // every alpha is 0xFF, the colors are unknown
+        kConstant,  // every pixel is fPixel (so transparent if fPixel == 0)
+    };
+    Kind   fKind;
+    GPixel fPixel;  // only for kConstant
+
+    static GDstState Unknown() { return { kUnknown, 0 }; }
+    static GDstState Opaque() { return { kOpaque, 0 }; }
+    static GDstState Constant(GPixel p) { return { kConstant, p }; }
+
+    bool isTransparent() const { return fKind == kConstant && fPixel == 0; }
+    bool isOpaque() const {
+        return fKind == kOpaque || (fKind == kConstant && GPixel_GetA(fPixel) == 0xFF);
+    }
+};
+
+/**
+ *  Tracks the GDstState of a bitmap, in bands of kBandRows rows. A canvas tells the tracker
+ *  about each clear() and each draw, and asks it about the rows a draw is about to touch.
+ *  Knowing the dst lets GAnalyzePaint() pick modes that do not read it (see GPaintAnalysis.h).
+ *
+ *  The tracker only ever forgets (or weakens) what it knows after a draw, so it is always safe.
+ */
+class GDstTracker {
+public:
+    enum { kBandRows = 16 };
+
+    GDstTracker(int height) : fBands((height + kBandRows - 1) / kBandRows, GDstState::Unknown()) {}
+
+    // Every pixel is now p
+    void clear(GPixel p);
+
+    // Forget everything (e.g. if the pixels were changed behind the canvas' back)
+    void reset();
+
+    // The state shared by every row in [top, bottom)
+    GDstState query(int top, int bottom) const;
+
+    // Rows [top, bottom) were drawn into with this (already analyzed) mode
+    void didDraw(int top, int bottom, GBlendMode, bool srcIsOpaque);
+
+private:
+    std::vector<GDstState> fBands;
+};
+
+#endif
@@ -0,0 +1,147 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GEdge.h"
+#include "../include/GMath.h"
+#include "../include/GMatrix.h"
+#include "../include/GPath.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+static std::atomic<int> gEdgeCount{0};
+
+static double pin(double x, double min, double max) {
+    return x < max ? (x > min ? x : min) : max;
+}
+
+/*
+ *  Set up the edge for the rows whose centers are in [top, bottom) of the line that crosses y0
+ *  at x0, then move it by (dx, dy). In range ([minX, maxX] before moving), x is evaluated there
+ *  and then walked with the line's slope; out of range, the edge is vertical at +-kMaxCoord.
+ */
+static bool set_piece(GEdge* edge, double x0, double y0, double slope, double top, double bottom,
+                      double minX, double maxX, int dx, int dy, int winding) {
+    const GFixed max = GEdge::kMaxCoord * GFixed1;
+    // row y is covered if top <= y + 0.5 < bottom
+    const int t = (int)std::ceil(top - 0.5),
+              b = (int)std::ceil(bottom - 0.5);
+    if (t >= b) {
+        return false;
+    }
+    const double mid = x0 + slope * ((top + bottom) * 0.5 - y0);
+    GFixed x = mid < minX ? -max : max,
+           step = 0;
+    if (mid >= minX && mid <= maxX) {
+        const double fx = pin(x0 + slope * (t + 0.5 - y0), minX, maxX);    // only pins rounding
+        // whole pixels are added after converting, so moving the line moves this exactly
+        x = (GFixed)((int64_t)std::floor(fx * GFixed1) + (int64_t)dx * GFixed1);
+        // x stays in range, so if there are 2 or more rows (dy > 1), |slope| < 2 * kMaxCoord;
+        // with only 1, it is not used
+        step = (GFixed)(pin(slope, -2.0 * GEdge::kMaxCoord, 2.0 * GEdge::kMaxCoord) * GFixed1);
+    }
+    edge->fTop = t + dy;
+    edge->fBottom = b + dy;
+    edge->fX = x;
+    edge->fDX = step;
+    edge->fWinding = winding;
+    gEdgeCount.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+int GEdge::SetLine(GPoint p0, GPoint p1, GEdge edges[], int dx, int dy) {
+    if (!(std::isfinite(p0.x) && std::isfinite(p0.y) &&
+          std::isfinite(p1.x) && std::isfinite(p1.y))) {
+        return 0;
+    }
+    int winding = 1;
+    if (p0.y > p1.y) {
+        std::swap(p0, p1);
+        winding = -1;
+    }
+    // the range, before moving by (dx, dy)
+    const double max = kMaxCoord;
+    const double minX = -max - dx, maxX = max - dx;
+    const double top = std::max<double>(p0.y, -max - dy),
+                 bottom = std::min<double>(p1.y, max - dy);
+    if (!(top < bottom)) {
+        return 0;
+    }
+    // of the whole line, not of the part that is left
+    const double slope = ((double)p1.x - p0.x) / ((double)p1.y - p0.y);
+
+    // split where it crosses minX and maxX
+    double ys[4] = { top, bottom, bottom, bottom };
+    int n = 1;
+    if (slope != 0) {
+        for (double x : { minX, maxX }) {
+            const double y = p0.y + (x - p0.x) / slope;
+            if (y > top && y < bottom) {
+                ys[n++] = y;
+            }
+        }
+        std::sort(ys + 1, ys + n);
+    }
+    ys[n] = bottom;
+
+    int count = 0;
+    for (int i = 0; i < n; ++i) {
+        count += set_piece(&edges[count], p0.x, p0.y, slope, ys[i], ys[i + 1], minX, maxX, dx, dy,
+                           winding);
+    }
+    return count;
+}
+
+int GMaxEdgeCount(const GPath& path) {
+    return GEdge::kMaxPerLine * (int)path.countPoints();
+}
+
+int GBuildEdges(const GPath& path, const GMatrix& ctm, GEdge edges[], GRect* bounds) {
+    // map with just the fraction of the translate, and let SetLine() add the whole pixels
+    GMatrix m = ctm;
+    int dx = 0, dy = 0;
+    if (std::abs(ctm[4]) < kGEdge_MaxWholeTranslate && std::abs(ctm[5]) < kGEdge_MaxWholeTranslate) {
+        dx = (int)std::floor(ctm[4]);
+        dy = (int)std::floor(ctm[5]);
+        m[4] = ctm[4] - dx;     // exact
+        m[5] = ctm[5] - dy;
+    }
+
+    int count = 0;
+    float l = INFINITY, t = INFINITY, r = -INFINITY, b = -INFINITY;
+    GPoint pts[GPath::kMaxNextPoints];
+    GPath::Edger edger(path);
+    while (edger.next(pts)) {
+        m.mapPoints(pts, 2);
+        count += GEdge::SetLine(pts[0], pts[1], edges + count, dx, dy);
+        for (int i = 0; i < 2; ++i) {
+            l = std::min(l, pts[i].x);
+            t = std::min(t, pts[i].y);
+            r = std::max(r, pts[i].x);
+            b = std::max(b, pts[i].y);
+        }
+    }
+    assert(count <= GMaxEdgeCount(path));
+    if (bounds) {
+        *bounds = l <= r ? GRect::LTRB(l + dx, t + dy, r + dx, b + dy) : GRect::WH(0, 0);
+    }
+    return count;
+}
+
+void GOffsetEdges(GEdge edges[], int count, int dx, int dy) {
+    const GFixed fdx = dx * GFixed1;
+    for (int i = 0; i < count; ++i) {
+        edges[i].fTop += dy;
+        edges[i].fBottom += dy;
+        edges[i].fX += fdx;
+    }
+}
+
+int GEdge_Count() {
+    return gEdgeCount.load(std::memory_order_relaxed);
+}
+
+void GEdge_ResetCounts() {
+    gEdgeCount.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,94 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GEdge_DEFINED
+#define GEdge_DEFINED
+
+#include "../include/GPoint.h"
+#include "../include/GRect.h"
+
+// 16.16 fixed point
+typedef int32_t GFixed;
+
+constexpr GFixed GFixed1 = 1 << 16;
+
+static inline GFixed GFloatToFixed(float x) {
+    return (GFixed)(x * GFixed1);
+}
+
+// Rounds halves up, like GRoundToInt()
+static inline int GFixedRoundToInt(GFixed x) {
+    return (x + (GFixed1 >> 1)) >> 16;
+}
+
+/**
+ *  A line, set up for scan conversion by sampling at pixel centers: it covers the rows whose
+ *  centers are in [top, bottom) of the line, and fX is where it crosses the center of the
+ *  current row. The floats are converted once, in set(); walking the edge is then integer
+ *  adds, so every compiler (and instruction set) produces the same spans.
+ *
+ *      for (int y = edge.fTop; y < edge.fBottom; ++y) {
+ *          int x = GFixedRoundToInt(edge.fX);
+ *          ...
+ *          edge.fX += edge.fDX;
+ *      }
+ *
+ *  Rows beyond +-kMaxCoord are dropped, and the parts of a line that are further than that to
+ *  the left or right become vertical edges at +-kMaxCoord: every pixel in range sees the same
+ *  crossing (or none) either way. So x stays in range, and everything else keeps the exact slope
+ *  of the whole line, however far away its endpoints are.
+ */
+struct GEdge {
+    enum {
+        kMaxCoord = 1 << 13,    // so x + dx cannot overflow either
+        kMaxPerLine = 3,        // left of, inside, and right of the range
+    };
+
+    int    fTop, fBottom;   // rows [fTop, fBottom), never empty
+    GFixed fX;              // x at the center of row fTop (then of each row, as it is walked)
+    GFixed fDX;             // change in x from one row to the next
+    int    fWinding;        // +1 if p0 is above p1, else -1
+
+    /**
+     *  Set up the edges for the line p0..p1, moved by whole pixels (dx, dy), in edges[] (which
+     *  must have room for kMaxPerLine), from top to bottom, and return how many there are: 0 if
+     *  it crosses no row centers. The move is added after converting to rows and 16.16, so if
+     *  no part of the line is out of range either way, these are exactly the edges for (0, 0)
+     *  moved by GOffsetEdges().
+     */
+    static int SetLine(GPoint p0, GPoint p1, GEdge edges[], int dx = 0, int dy = 0);
+};
+
+class GMatrix;
+class GPath;
+
+// GBuildEdges() adds translates smaller than this to its edges in whole pixels
+constexpr float kGEdge_MaxWholeTranslate = 1 << 24;
+
+/**
+ *  Set up an edge for each line of the path (including the ones that close its contours),
+ *  mapped by ctm, skipping those that cross no row centers. Returns the number of edges, which
+ *  is at most GMaxEdgeCount(path), the size edges[] must have.
+ *
+ *  The path is mapped with just the fraction of the ctm's translate, and the whole pixels are
+ *  added by SetLine(). So if bounds (set to the device bounds of the mapped path, if not null)
+ *  is inside +-kMaxCoord, the edges for ctms that only differ by whole pixels are exact offsets
+ *  of each other.
+ */
+int GMaxEdgeCount(const GPath&);
+int GBuildEdges(const GPath&, const GMatrix& ctm, GEdge edges[], GRect* bounds = nullptr);
+
+/**
+ *  Move the edges by whole pixels, without setting them up again: these are exactly the edges
+ *  that GBuildEdges() makes with the ctm followed by Translate(dx, dy), as long as the path is
+ *  inside +-kMaxCoord in both places. e.g. for instances of a path that only differ by integer
+ *  translates.
+ */
+void GOffsetEdges(GEdge edges[], int count, int dx, int dy);
+
+// Counts are for all threads, since the last reset.
+int  GEdge_Count();     // number of edges set up (counted in SetLine()'s return values)
+void GEdge_ResetCounts();
+
+#endif
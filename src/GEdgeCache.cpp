@@ -0,0 +1,84 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GEdgeCache.h"
+#include "../include/GPath.h"
+#include <algorithm>
+#include <cmath>
+
+static bool in_range(const GRect& r) {
+    const float max = GEdge::kMaxCoord - 1;     // some slack for rounding
+    return r.left >= -max && r.top >= -max && r.right <= max && r.bottom <= max;
+}
+
+/*
+ *  If the edges that GBuildEdges() makes with a are exactly those it made with b (which had
+ *  device bounds), moved by (dx, dy) whole pixels, return true and set them. a and b must
+ *  only differ by whole pixels of translate, and neither may have had to clip the edges.
+ */
+static bool integer_offset(const GMatrix& a, const GMatrix& b, const GRect& bounds,
+                           int* dx, int* dy) {
+    if (a[0] != b[0] || a[1] != b[1] || a[2] != b[2] || a[3] != b[3]) {
+        return false;
+    }
+    if (a[4] == b[4] && a[5] == b[5]) {
+        *dx = *dy = 0;
+        return true;
+    }
+    const float max = kGEdge_MaxWholeTranslate;
+    for (int i : {4, 5}) {
+        if (!(std::abs(a[i]) < max && std::abs(b[i]) < max) ||
+                a[i] - std::floor(a[i]) != b[i] - std::floor(b[i])) {
+            return false;
+        }
+    }
+    const int x = (int)std::floor(a[4]) - (int)std::floor(b[4]),
+              y = (int)std::floor(a[5]) - (int)std::floor(b[5]);
+    if (!(in_range(bounds) && in_range(bounds.offset(x, y)))) {
+        return false;
+    }
+    *dx = x;
+    *dy = y;
+    return true;
+}
+
+int GEdgeCache::getEdges(const GPath& path, const GMatrix& ctm, GEdge edges[]) {
+    fUseCount += 1;
+    Entry* oldest = &fEntries[0];
+    for (Entry& e : fEntries) {
+        int dx, dy;
+        if (e.fPathID == path.uniqueID() && integer_offset(ctm, e.fCTM, e.fBounds, &dx, &dy)) {
+            e.fLastUse = fUseCount;
+            const int count = (int)e.fEdges.size();
+            std::copy(e.fEdges.begin(), e.fEdges.end(), edges);
+            fHits += 1;
+            if (dx | dy) {
+                GOffsetEdges(edges, count, dx, dy);
+                fOffsetHits += 1;
+            }
+            return count;
+        }
+        if (e.fLastUse < oldest->fLastUse) {
+            oldest = &e;
+        }
+    }
+
+    fMisses += 1;
+    const int count = GBuildEdges(path, ctm, edges, &oldest->fBounds);
+    std::sort(edges, edges + count, [](const GEdge& a, const GEdge& b) {
+        return a.fTop < b.fTop;
+    });
+    oldest->fPathID = path.uniqueID();
+    oldest->fCTM = ctm;
+    oldest->fLastUse = fUseCount;
+    oldest->fEdges.assign(edges, edges + count);
+    return count;
+}
+
+void GEdgeCache::reset() {
+    for (Entry& e : fEntries) {
+        e.fPathID = 0;
+        e.fLastUse = 0;
+    }
+}
@@ -0,0 +1,58 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GEdgeCache_DEFINED
+#define GEdgeCache_DEFINED
+
+#include "GEdge.h"
+#include "../include/GMatrix.h"
+#include <vector>
+
+class GPath;
+
+/**
+ *  Remembers the edges (from GBuildEdges(), sorted by fTop) of the last few paths a canvas
+ *  drew, each with the ctm it was drawn with, keyed by GPath::uniqueID(). Drawing the same
+ *  path again then only copies its edges. If the ctm only differs from the cached one by a
+ *  whole number of pixels in x and y, the copies are moved with GOffsetEdges(), which gives
+ *  exactly the edges that building them again would (see GBuildEdges()), so a hit never
+ *  changes a pixel.
+ *
+ *  Each canvas (or thread) has its own cache, so there is no locking. When full, the least
+ *  recently used entry is replaced, reusing its storage.
+ */
+class GEdgeCache {
+public:
+    enum { kMaxEntries = 8 };
+
+    GEdgeCache() : fEntries(kMaxEntries) {}
+
+    /**
+     *  Write the path's edges, mapped by ctm and sorted by fTop, into edges[] (which must have
+     *  room for GMaxEdgeCount(path)), and return how many there are.
+     */
+    int getEdges(const GPath&, const GMatrix& ctm, GEdge edges[]);
+
+    int hits() const { return fHits; }              // includes offsetHits()
+    int offsetHits() const { return fOffsetHits; }  // hits whose edges had to be moved
+    int misses() const { return fMisses; }
+
+    // Forget all paths (but keep the storage)
+    void reset();
+
+private:
+    struct Entry {
+        uint32_t           fPathID = 0;     // 0 means unused
+        GMatrix            fCTM;
+        GRect              fBounds;         // of the path, mapped by fCTM
+        uint64_t           fLastUse = 0;
+        std::vector<GEdge> fEdges;
+    };
+
+    std::vector<Entry> fEntries;
+    uint64_t           fUseCount = 0;
+    int                fHits = 0, fOffsetHits = 0, fMisses = 0;
+};
+
+#endif
@@ -0,0 +1,284 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GMaskCache.h"
+#include "../include/GPath.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+static std::atomic<int> gHitCount{0};
+static std::atomic<int> gMissCount{0};
+
+void GRLEMask::blit(GBlitter* blitter, int dx, int dy, const GIRect& clip) const {
+    for (const Row& row : fRows) {
+        const int y = row.fY + dy;
+        if (y < clip.top || y >= clip.bottom) {
+            continue;
+        }
+        const GAlphaRun* runs = &fRuns[row.fRun];
+        int x = row.fX + dx;
+        if (!row.fOpaque) {
+            int width = 0;
+            for (const GAlphaRun* r = runs; r->fCount; ++r) {
+                width += r->fCount;
+            }
+            if (x >= clip.left && x + width <= clip.right) {
+                blitter->blitAntiH(x, y, runs);     // no clipping needed, so pass the runs as is
+                continue;
+            }
+        }
+        for (; runs->fCount; x += runs->fCount, ++runs) {
+            const int L = std::max(x, clip.left),
+                      R = std::min(x + runs->fCount, clip.right);
+            if (L >= R || runs->fAlpha == 0) {
+                continue;
+            }
+            if (runs->fAlpha == 0xFF) {
+                blitter->blitH(L, y, R - L);
+            } else {
+                const GAlphaRun clipped[] = {{(uint16_t)(R - L), runs->fAlpha}, {0, 0}};
+                blitter->blitAntiH(L, y, clipped);
+            }
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GRLEMaskBuilder::blitH(int x, int y, int width) {
+    this->append(x, y, width, 0xFF);
+}
+
+void GRLEMaskBuilder::blitAntiH(int x, int y, const GAlphaRun runs[]) {
+    for (; runs->fCount; x += runs->fCount, ++runs) {
+        this->append(x, y, runs->fCount, runs->fAlpha);
+    }
+}
+
+void GRLEMaskBuilder::append(int x, int y, int count, uint8_t alpha) {
+    if (count <= 0 || alpha == 0) {
+        return;     // gaps are added when (and if) something follows them
+    }
+    std::vector<GRLEMask::Row>& rows = fMask.fRows;
+    std::vector<GAlphaRun>& runs = fMask.fRuns;
+    if (rows.empty() || rows.back().fY != y) {
+        assert(rows.empty() || rows.back().fY < y);
+        this->finishRow();
+        rows.push_back({y, x, (int)runs.size(), true});
+        fRowEnd = x;
+    }
+    assert(x >= fRowEnd);
+    if (x > fRowEnd) {
+        for (int gap = x - fRowEnd; gap > 0; gap -= 0xFFFF) {
+            runs.push_back({(uint16_t)std::min(gap, 0xFFFF), 0});
+        }
+    }
+    rows.back().fOpaque &= alpha == 0xFF;
+    fRowEnd = x + count;
+    for (; count > 0; count -= 0xFFFF) {
+        const int n = std::min(count, 0xFFFF);
+        if ((int)runs.size() > rows.back().fRun && runs.back().fAlpha == alpha &&
+                runs.back().fCount + n <= 0xFFFF) {
+            runs.back().fCount += n;
+        } else {
+            runs.push_back({(uint16_t)n, alpha});
+        }
+    }
+}
+
+void GRLEMaskBuilder::finishRow() {
+    if (fMask.fRows.empty()) {
+        return;
+    }
+    const GRLEMask::Row& row = fMask.fRows.back();
+    fMask.fRuns.push_back({0, 0});
+    const GIRect r = GIRect::LTRB(row.fX, row.fY, fRowEnd, row.fY + 1);
+    if (fMask.fBounds.isEmpty()) {
+        fMask.fBounds = r;
+    } else {
+        fMask.fBounds = GIRect::LTRB(std::min(fMask.fBounds.left, r.left),
+                                     std::min(fMask.fBounds.top, r.top),
+                                     std::max(fMask.fBounds.right, r.right),
+                                     std::max(fMask.fBounds.bottom, r.bottom));
+    }
+}
+
+GRLEMask GRLEMaskBuilder::detach() {
+    this->finishRow();
+    GRLEMask mask = std::move(fMask);
+    fMask = GRLEMask();
+    fRowEnd = 0;
+    return mask;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool GMaskCache::Key::operator==(const Key& k) const {
+    return fPathID == k.fPathID && fFracX == k.fFracX && fFracY == k.fFracY &&
+           fAntiAlias == k.fAntiAlias && !memcmp(fLinear, k.fLinear, sizeof(fLinear));
+}
+
+size_t GMaskCache::KeyHash::operator()(const Key& k) const {
+    size_t hash = k.fPathID;
+    for (float f : k.fLinear) {
+        uint32_t bits;
+        memcpy(&bits, &f, 4);
+        hash = hash * 31 + bits;
+    }
+    return hash * 31 + (k.fFracX * kSubpixelSteps + k.fFracY) * 2 + k.fAntiAlias;
+}
+
+// Split t into whole pixels and a number of 1/kSubpixelSteps, rounding down
+static bool split_translate(float t, int* whole, int* frac) {
+    if (!(std::abs(t) < (1 << 20))) {
+        return false;   // too large to key on (or NaN)
+    }
+    const int steps = (int)std::floor(t * GMaskCache::kSubpixelSteps);
+    *whole = (int)std::floor(steps / (float)GMaskCache::kSubpixelSteps);
+    *frac = steps - *whole * GMaskCache::kSubpixelSteps;
+    return true;
+}
+
+// The bounds of the path's points, mapped by ctm
+static GRect map_bounds(const GPath& path, const GMatrix& ctm) {
+    const GRect r = path.bounds();
+    GPoint pts[] = {{r.left, r.top}, {r.right, r.top}, {r.right, r.bottom}, {r.left, r.bottom}};
+    ctm.mapPoints(pts, 4);
+    GRect bounds = GRect::LTRB(pts[0].x, pts[0].y, pts[0].x, pts[0].y);
+    for (const GPoint& p : pts) {
+        bounds = GRect::LTRB(std::min(bounds.left, p.x), std::min(bounds.top, p.y),
+                             std::max(bounds.right, p.x), std::max(bounds.bottom, p.y));
+    }
+    return bounds;
+}
+
+bool GMaskCache::CanCache(const GPath& path, const GMatrix& ctm, const GIRect& limit) {
+    const GRect r = map_bounds(path, ctm);
+    // also false if not finite
+    return r.left >= limit.left && r.top >= limit.top &&
+           r.right <= limit.right && r.bottom <= limit.bottom;
+}
+
+GMatrix GMaskCache::QuantizeCTM(const GMatrix& ctm) {
+    GMatrix m = ctm;
+    int whole, frac;
+    for (int i : {4, 5}) {
+        if (split_translate(ctm[i], &whole, &frac)) {
+            m[i] = whole + frac / (float)kSubpixelSteps;    // exact
+        }
+    }
+    return m;
+}
+
+bool GMaskCache::MakeKey(const GPath& path, const GMatrix& ctm, bool antiAlias,
+                         Key* key, GMatrix* rasterCTM, int* dx, int* dy) {
+    *rasterCTM = QuantizeCTM(ctm);
+    *dx = *dy = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (!std::isfinite(ctm[i])) {
+            return false;
+        }
+    }
+    int wx, wy, fx, fy;
+    if (!split_translate(ctm[4], &wx, &fx) || !split_translate(ctm[5], &wy, &fy)) {
+        return false;
+    }
+    // Rasterize near the origin, wherever the path's own coordinates are, so that the scan
+    // converter never has to clip it (GEdge::kMaxCoord). This only depends on the key.
+    const GMatrix linear(ctm[0], ctm[2], 0, ctm[1], ctm[3], 0);
+    const GRect r = map_bounds(path, linear);
+    if (!(std::abs(r.left) < (1 << 20) && std::abs(r.top) < (1 << 20))) {
+        return false;
+    }
+    const int ox = (int)std::floor(r.left),
+              oy = (int)std::floor(r.top);
+
+    key->fPathID = path.uniqueID();
+    for (int i = 0; i < 4; ++i) {
+        key->fLinear[i] = ctm[i];
+    }
+    key->fFracX = fx;
+    key->fFracY = fy;
+    key->fAntiAlias = antiAlias;
+    (*rasterCTM)[4] = fx / (float)kSubpixelSteps - ox;
+    (*rasterCTM)[5] = fy / (float)kSubpixelSteps - oy;
+    *dx = wx + ox;
+    *dy = wy + oy;
+    return true;
+}
+
+const GRLEMask* GMaskCache::find(const GPath& path, const GMatrix& ctm, bool antiAlias,
+                                 GMatrix* rasterCTM, int* dx, int* dy) {
+    Key key;
+    if (!MakeKey(path, ctm, antiAlias, &key, rasterCTM, dx, dy)) {
+        return nullptr;
+    }
+    auto iter = fMap.find(key);
+    if (iter == fMap.end()) {
+        fMisses += 1;
+        gMissCount.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    fHits += 1;
+    gHitCount.fetch_add(1, std::memory_order_relaxed);
+    fLRU.splice(fLRU.begin(), fLRU, iter->second);
+    return &iter->second->fMask;
+}
+
+const GRLEMask* GMaskCache::add(const GPath& path, const GMatrix& ctm, bool antiAlias,
+                                GRLEMask&& mask) {
+    Key key;
+    GMatrix rasterCTM;
+    int dx, dy;
+    const size_t bytes = mask.bytes();
+    if (!MakeKey(path, ctm, antiAlias, &key, &rasterCTM, &dx, &dy) || bytes > fBudget) {
+        fUncached = std::move(mask);
+        return &fUncached;
+    }
+    auto iter = fMap.find(key);
+    if (iter != fMap.end()) {
+        // already there (find() was not called first): replace it
+        fBytesUsed -= iter->second->fMask.bytes();
+        fLRU.erase(iter->second);
+        fMap.erase(iter);
+    }
+    this->purge(bytes);
+    fLRU.push_front({key, std::move(mask)});
+    fMap[key] = fLRU.begin();
+    fBytesUsed += bytes;
+    return &fLRU.front().fMask;
+}
+
+// Drop the least recently used masks until there is room for bytes more
+void GMaskCache::purge(size_t bytes) {
+    while (!fLRU.empty() && fBytesUsed + bytes > fBudget) {
+        const Entry& oldest = fLRU.back();
+        fBytesUsed -= oldest.fMask.bytes();
+        fMap.erase(oldest.fKey);
+        fLRU.pop_back();
+        fEvictions += 1;
+    }
+}
+
+void GMaskCache::reset() {
+    fLRU.clear();
+    fMap.clear();
+    fUncached = GRLEMask();
+    fBytesUsed = 0;
+}
+
+int GMaskCache_HitCount() {
+    return gHitCount.load(std::memory_order_relaxed);
+}
+
+int GMaskCache_MissCount() {
+    return gMissCount.load(std::memory_order_relaxed);
+}
+
+void GMaskCache_ResetCounts() {
+    gHitCount.store(0, std::memory_order_relaxed);
+    gMissCount.store(0, std::memory_order_relaxed);
+}
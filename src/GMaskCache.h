@@ -0,0 +1,184 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GMaskCache_DEFINED
+#define GMaskCache_DEFINED
+
+#include "GBlitter.h"
+#include "../include/GMatrix.h"
+#include "../include/GRect.h"
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+class GPath;
+
+/**
+ *  The coverage of a draw, run-length encoded: for each covered row, the GAlphaRuns that
+ *  a scan converter produced (aliased spans are runs of 0xFF). Blitting it replays those runs
+ *  through any blitter, so a path that is drawn again only pays for its blending.
+ */
+class GRLEMask {
+public:
+    GRLEMask() : fBounds(GIRect::LTRB(0, 0, 0, 0)) {}
+
+    bool isEmpty() const { return fRows.empty(); }
+
+    // The covered pixels (before any offset)
+    GIRect bounds() const { return fBounds; }
+
+    // Memory used, for GMaskCache's budget
+    size_t bytes() const {
+        return sizeof(*this) + fRows.size() * sizeof(Row) + fRuns.size() * sizeof(GAlphaRun);
+    }
+
+    // Replay the coverage, moved by (dx, dy), into the pixels of the blitter inside clip
+    void blit(GBlitter*, int dx, int dy, const GIRect& clip) const;
+
+private:
+    friend class GRLEMaskBuilder;
+
+    struct Row {
+        int  fY, fX;
+        int  fRun;      // index of its first run in fRuns; the row's runs end with fCount == 0
+        bool fOpaque;   // every run is 0 or 0xFF, so it can be blitted with blitH()
+    };
+
+    std::vector<Row>       fRows;
+    std::vector<GAlphaRun> fRuns;
+    GIRect                 fBounds;
+};
+
+/**
+ *  A blitter that records its spans into a GRLEMask instead of drawing them. Scan convert a
+ *  path into it (top to bottom, and left to right within a row, as they already do), then
+ *  detach() the mask.
+ */
+class GRLEMaskBuilder : public GBlitter {
+public:
+    GRLEMaskBuilder() : fRowEnd(0) {}
+
+    void blitH(int x, int y, int width) override;
+    void blitAntiH(int x, int y, const GAlphaRun runs[]) override;
+
+    GRLEMask detach();
+
+private:
+    void append(int x, int y, int count, uint8_t alpha);
+    void finishRow();
+
+    GRLEMask fMask;
+    int      fRowEnd;   // x after the last run of the current row
+};
+
+/**
+ *  Remembers the coverage masks of paths that are drawn again unchanged, keyed by
+ *  GPath::uniqueID(), the ctm and whether the draw is antialiased. The ctm's translate only
+ *  counts to 1/kSubpixelSteps of a pixel: masks are rasterized at that fraction, and moved by
+ *  the whole pixels when blitted, so the same path drawn at another integer position is a hit.
+ *
+ *      if (!GMaskCache::CanCache(path, ctm, clip.bounds())) {
+ *          scan.fillPath(path, GMaskCache::QuantizeCTM(ctm), clip.bounds(), blitter);
+ *          return;
+ *      }
+ *      GMatrix rasterCTM;
+ *      int dx, dy;
+ *      const GRLEMask* mask = cache.find(path, ctm, aa, &rasterCTM, &dx, &dy);
+ *      if (!mask) {
+ *          GRLEMaskBuilder builder;
+ *          scan.fillPath(path, rasterCTM, GScanConverter::NoClip(), &builder);
+ *          mask = cache.add(path, ctm, aa, builder.detach());
+ *      }
+ *      mask->blit(blitter, dx, dy, clip.bounds());
+ *
+ *  Masks are not clipped (so that they can be reused under any clip), so only paths that are
+ *  entirely inside the clip are cached: a mask is never larger than what it can draw into.
+ *  rasterCTM puts the path near the origin (it is moved back by dx, dy), so its coordinates are
+ *  always in range for the scan converter. The least recently used masks are dropped to stay
+ *  within the budget (in bytes). Each canvas has its own cache: no locking.
+ */
+class GMaskCache {
+public:
+    enum {
+        kDefaultBudget  = 1 << 22,
+        kSubpixelSteps  = 4,
+    };
+
+    explicit GMaskCache(size_t budget = kDefaultBudget) : fBudget(budget) {}
+
+    /**
+     *  Return true if the path, drawn with ctm, is inside limit (e.g. the clip bounds), and so
+     *  should go through the cache. Otherwise, draw it directly.
+     */
+    static bool CanCache(const GPath&, const GMatrix& ctm, const GIRect& limit);
+
+    /**
+     *  The ctm with its translate rounded down to 1/kSubpixelSteps of a pixel, which is where
+     *  a blitted mask draws the path. Paths that are not cached should be drawn with this, so
+     *  that they look the same either way (e.g. when a different clip decides CanCache()).
+     */
+    static GMatrix QuantizeCTM(const GMatrix& ctm);
+
+    /**
+     *  Return the mask for path drawn with ctm, or null if it is not cached. Either way, set
+     *  rasterCTM to the matrix to rasterize the path with, and (dx, dy) to where to blit the
+     *  mask. If the ctm is too large to key on, rasterCTM is QuantizeCTM(ctm) and the offset
+     *  is 0.
+     */
+    const GRLEMask* find(const GPath&, const GMatrix& ctm, bool antiAlias,
+                         GMatrix* rasterCTM, int* dx, int* dy);
+
+    /**
+     *  Remember the mask that was rasterized with the rasterCTM from find(), and return it.
+     *  The pointer is good until the next call to add() or reset(). Masks larger than the
+     *  budget (or with a ctm that find() could not key) are returned, but not kept.
+     */
+    const GRLEMask* add(const GPath&, const GMatrix& ctm, bool antiAlias, GRLEMask&&);
+
+    int    hits() const { return fHits; }
+    int    misses() const { return fMisses; }
+    int    evictions() const { return fEvictions; }
+    int    count() const { return (int)fLRU.size(); }
+    size_t bytesUsed() const { return fBytesUsed; }
+    size_t budget() const { return fBudget; }
+
+    // Drop every mask
+    void reset();
+
+private:
+    struct Key {
+        uint32_t fPathID;
+        float    fLinear[4];            // the ctm, without its translate
+        int      fFracX, fFracY;        // the fraction of the translate, in kSubpixelSteps
+        bool     fAntiAlias;
+
+        bool operator==(const Key&) const;
+    };
+    struct KeyHash {
+        size_t operator()(const Key&) const;
+    };
+    struct Entry {
+        Key      fKey;
+        GRLEMask fMask;
+    };
+
+    // Returns false if the ctm can not be keyed (e.g. it is not finite)
+    static bool MakeKey(const GPath&, const GMatrix& ctm, bool antiAlias,
+                        Key*, GMatrix* rasterCTM, int* dx, int* dy);
+    void purge(size_t bytes);
+
+    const size_t     fBudget;
+    GRLEMask         fUncached;     // the last mask that add() could not keep
+    std::list<Entry> fLRU;  // the most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> fMap;
+    size_t           fBytesUsed = 0;
+    int              fHits = 0, fMisses = 0, fEvictions = 0;
+};
+
+// Counts are for all threads, since the last reset.
+int  GMaskCache_HitCount();
+int  GMaskCache_MissCount();
+void GMaskCache_ResetCounts();
+
+#endif
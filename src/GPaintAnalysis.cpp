@@ -0,0 +1,170 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GPaintAnalysis.h"
+#include "../include/GShader.h"
+
+#include <atomic>
+
+constexpr int kReductionCount = static_cast<int>(GPaintReduction::kLast) + 1;
+
+static std::atomic<int> gCounts[kReductionCount];
+static std::atomic<int> gDrawCount{0};
+
+static const char* gNames[] = {
+    "dst_noop", "transparent_noop", "transparent_clear", "opaque_srcover", "opaque_dstin",
+    "opaque_dstout", "opaque_srcatop", "opaque_dstatop", "opaque_xor", "transparent_dst_noop",
+    "transparent_dst_store", "opaque_dst_noop", "opaque_dst_reduce", "clear_shader",
+};
+static_assert(GARRAY_COUNT(gNames) == kReductionCount, "one name per reduction");
+
+static void count(GPaintReduction r) {
+    gCounts[static_cast<int>(r)].fetch_add(1, std::memory_order_relaxed);
+}
+
+// With S == 0 and Sa == 0, every mode is either D or 0
+static bool transparent_leaves_dst(GBlendMode mode) {
+    switch (mode) {
+        case GBlendMode::kDst:
+        case GBlendMode::kSrcOver:
+        case GBlendMode::kDstOver:
+        case GBlendMode::kDstOut:
+        case GBlendMode::kSrcATop:
+        case GBlendMode::kXor:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// With D == 0 and Da == 0, every mode is either 0 (i.e. D) or S
+static bool transparent_dst_gets_src(GBlendMode mode) {
+    switch (mode) {
+        case GBlendMode::kSrc:
+        case GBlendMode::kSrcOver:
+        case GBlendMode::kDstOver:
+        case GBlendMode::kSrcOut:
+        case GBlendMode::kDstATop:
+        case GBlendMode::kXor:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Da == 1, so 1 - Da == 0
+static GBlendMode reduce_for_opaque_dst(GBlendMode mode) {
+    switch (mode) {
+        case GBlendMode::kSrcIn:    return GBlendMode::kSrc;
+        case GBlendMode::kSrcOut:   return GBlendMode::kClear;
+        case GBlendMode::kSrcATop:  return GBlendMode::kSrcOver;
+        case GBlendMode::kDstATop:  return GBlendMode::kDstIn;
+        case GBlendMode::kXor:      return GBlendMode::kDstOut;
+        default:                    return mode;
+    }
+}
+
+GPaintAnalysis GAnalyzePaint(const GPaint& paint) {
+    return GAnalyzePaint(paint, GDstState::Unknown());
+}
+
+GPaintAnalysis GAnalyzePaint(const GPaint& paint, const GDstState& dst) {
+    gDrawCount.fetch_add(1, std::memory_order_relaxed);
+
+    GShader* shader = paint.peekShader();
+    const bool opaque = shader ? shader->isOpaque() : paint.getAlpha() >= 1;
+    const bool transparent = !shader && paint.getAlpha() <= 0;
+    GPaintAnalysis result = { paint.getBlendMode(), shader, false, opaque };
+
+    auto reduce = [&result](GPaintReduction r, GBlendMode mode) {
+        count(r);
+        result.fMode = mode;
+    };
+    auto skip = [&result](GPaintReduction r) {
+        count(r);
+        result.fSkip = true;
+    };
+
+    if (result.fMode == GBlendMode::kDst) {
+        skip(GPaintReduction::kDstNoop);
+        return result;
+    }
+    if (transparent) {
+        if (transparent_leaves_dst(result.fMode)) {
+            skip(GPaintReduction::kTransparentNoop);
+            return result;
+        }
+        if (result.fMode != GBlendMode::kClear) {
+            reduce(GPaintReduction::kTransparentClear, GBlendMode::kClear);
+        }
+    } else if (opaque) {
+        // Sa == 1, so 1 - Sa == 0
+        switch (result.fMode) {
+            case GBlendMode::kSrcOver:
+                reduce(GPaintReduction::kOpaqueSrcOver, GBlendMode::kSrc);
+                break;
+            case GBlendMode::kDstIn:
+                skip(GPaintReduction::kOpaqueDstIn);
+                return result;
+            case GBlendMode::kDstOut:
+                reduce(GPaintReduction::kOpaqueDstOut, GBlendMode::kClear);
+                break;
+            case GBlendMode::kSrcATop:
+                reduce(GPaintReduction::kOpaqueSrcATop, GBlendMode::kSrcIn);
+                break;
+            case GBlendMode::kDstATop:
+                reduce(GPaintReduction::kOpaqueDstATop, GBlendMode::kDstOver);
+                break;
+            case GBlendMode::kXor:
+                reduce(GPaintReduction::kOpaqueXor, GBlendMode::kSrcOut);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (dst.isTransparent()) {
+        if (!transparent_dst_gets_src(result.fMode)) {
+            skip(GPaintReduction::kTransparentDstNoop);
+            return result;
+        }
+        if (result.fMode != GBlendMode::kSrc) {
+            reduce(GPaintReduction::kTransparentDstStore, GBlendMode::kSrc);
+        }
+    } else if (dst.isOpaque()) {
+        if (result.fMode == GBlendMode::kDstOver) {
+            skip(GPaintReduction::kOpaqueDstNoop);
+            return result;
+        }
+        const GBlendMode mode = reduce_for_opaque_dst(result.fMode);
+        if (mode != result.fMode) {
+            reduce(GPaintReduction::kOpaqueDstReduce, mode);
+        }
+    }
+
+    if (result.fMode == GBlendMode::kClear && result.fShader) {
+        count(GPaintReduction::kClearShader);
+        result.fShader = nullptr;
+    }
+    return result;
+}
+
+const char* GPaintReduction_Name(GPaintReduction r) {
+    return gNames[static_cast<int>(r)];
+}
+
+int GPaintAnalysis_Count(GPaintReduction r) {
+    return gCounts[static_cast<int>(r)].load(std::memory_order_relaxed);
+}
+
+int GPaintAnalysis_DrawCount() {
+    return gDrawCount.load(std::memory_order_relaxed);
+}
+
+void GPaintAnalysis_ResetCounts() {
+    for (auto& c : gCounts) {
+        c.store(0, std::memory_order_relaxed);
+    }
+    gDrawCount.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,63 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GPaintAnalysis_DEFINED
+#define GPaintAnalysis_DEFINED
+
+#include "../include/GPaint.h"
+#include "GDstTracker.h"
+
+/**
+ *  What a draw really has to do with its paint. Many paints reduce to something cheaper:
+ *  e.g. kSrcOver with an opaque src is kSrc, and kDst never changes the dst.
+ */
+struct GPaintAnalysis {
+    GBlendMode fMode;       // use this instead of paint.getBlendMode()
+    GShader*   fShader;     // use this instead of paint.peekShader() (null if it cannot matter)
+    bool       fSkip;       // the draw cannot change any pixels, so need not happen at all
+    bool       fSrcIsOpaque;
+};
+
+/**
+ *  Call once per draw, before any scan conversion. The result gives the same pixels as the
+ *  original paint, bit for bit. The src is opaque if the shader isOpaque(), or (with no shader)
+ *  if the color's alpha is 1; it is transparent if there is no shader and the alpha is 0.
+ */
+GPaintAnalysis GAnalyzePaint(const GPaint&);
+
+/**
+ *  As above, but also using what is known about the dst pixels the draw will touch (e.g. from
+ *  a GDstTracker). E.g. kSrcOver onto a transparent dst is kSrc, which never reads the dst,
+ *  and kDstOver onto an opaque dst is skipped.
+ */
+GPaintAnalysis GAnalyzePaint(const GPaint&, const GDstState&);
+
+// The rules GAnalyzePaint() applies. Each one that fires is counted.
+enum class GPaintReduction {
+    kDstNoop,           // kDst                          -> skip
+    kTransparentNoop,   // transparent src, dst unchanged (e.g. kSrcOver) -> skip
+    kTransparentClear,  // transparent src, dst cleared   (e.g. kSrcIn)   -> kClear
+    kOpaqueSrcOver,     // opaque src, kSrcOver          -> kSrc
+    kOpaqueDstIn,       // opaque src, kDstIn            -> skip
+    kOpaqueDstOut,      // opaque src, kDstOut           -> kClear
+    kOpaqueSrcATop,     // opaque src, kSrcATop          -> kSrcIn
+    kOpaqueDstATop,     // opaque src, kDstATop          -> kDstOver
+    kOpaqueXor,         // opaque src, kXor              -> kSrcOut
+    kTransparentDstNoop,  // transparent dst, result is 0 (e.g. kSrcIn)    -> skip
+    kTransparentDstStore, // transparent dst, result is S (e.g. kSrcOver)  -> kSrc
+    kOpaqueDstNoop,       // opaque dst, kDstOver                          -> skip
+    kOpaqueDstReduce,     // opaque dst, e.g. kSrcATop -> kSrcOver, kXor -> kDstOut
+    kClearShader,       // kClear (original or reduced) does not need the shader
+
+    kLast = kClearShader,
+};
+
+const char* GPaintReduction_Name(GPaintReduction);
+
+// Counts are for all threads, since the last reset.
+int  GPaintAnalysis_Count(GPaintReduction);
+int  GPaintAnalysis_DrawCount();    // number of calls to GAnalyzePaint()
+void GPaintAnalysis_ResetCounts();
+
+#endif
@@ -0,0 +1,27 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GParallelRows.h"
+#include <algorithm>
+
+int GCountRowBands(int threadCount, int top, int bottom, double pixels) {
+    const int rows = bottom - top;
+    if (threadCount <= 1 || pixels < kGParallelRows_MinPixels || rows <= 0) {
+        return 1;
+    }
+    return std::max(1, std::min(threadCount, rows / kGParallelRows_MinRows));
+}
+
+void GParallelRows(GThreadPool* pool, int top, int bottom, double pixels,
+                   const std::function<void(int band, int top, int bottom)>& fn) {
+    const int bands = pool ? GCountRowBands(pool->threadCount(), top, bottom, pixels) : 1;
+    if (bands == 1) {
+        fn(0, top, bottom);
+        return;
+    }
+    const int64_t rows = bottom - top;
+    pool->parallelFor(bands, [&](int band) {
+        fn(band, top + (int)(rows * band / bands), top + (int)(rows * (band + 1) / bands));
+    });
+}
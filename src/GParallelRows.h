@@ -0,0 +1,42 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GParallelRows_DEFINED
+#define GParallelRows_DEFINED
+
+#include "../include/GThreadPool.h"
+#include <functional>
+
+/**
+ *  Splitting one large draw (e.g. a full-screen shader drawRect, or a huge drawPath) across
+ *  threads, by bands of rows.
+ *
+ *  Each row of a draw is independent of the others, so if every band computes its rows the
+ *  same way the serial draw would, the pixels are identical. GEdge makes that easy: an edge's
+ *  x at row y is exactly fX + fDX * (y - fTop), whether it was walked there or jumped to.
+ *
+ *  Anything a draw sets up must be per band: blitters (they have scratch storage), arenas,
+ *  and shaders, which get their own context with GShader::clone() and setContext(). If the
+ *  shader can not be cloned, draw serially.
+ */
+enum {
+    kGParallelRows_MinPixels = 1 << 18,     // smaller draws are not worth splitting
+    kGParallelRows_MinRows   = 16,          // per band
+};
+
+/**
+ *  Return how many bands a draw of rows [top, bottom), covering about pixels, should be split
+ *  into across threadCount threads. 1 means draw it serially.
+ */
+int GCountRowBands(int threadCount, int top, int bottom, double pixels);
+
+/**
+ *  Call fn(band, bandTop, bandBottom) for each band of rows [top, bottom), spread across pool,
+ *  and wait for them all. The bands are in order, and cover each row once. If pool is null, or
+ *  the draw is too small (see GCountRowBands), this is one call with band 0 and all the rows.
+ */
+void GParallelRows(GThreadPool* pool, int top, int bottom, double pixels,
+                   const std::function<void(int band, int top, int bottom)>& fn);
+
+#endif
@@ -3,7 +3,10 @@
  */
 
 #include "../include/GPathBuilder.h"
+#include "GAxisRect.h"
 #include "../include/GMatrix.h"
+#include <algorithm>
+#include <cmath>
 
 void GPathBuilder::reset() {
     fPts.clear();
@@ -27,13 +30,109 @@ static bool is_identity(const GMatrix& m) {
            m[1] == 0 && m[2] == 0 && m[4] == 0 && m[5] == 0;
 }
 
+uint32_t GPath::NextUniqueID() {
+    static std::atomic<uint32_t> gNextID{1};
+    uint32_t id;
+    do {
+        id = gNextID.fetch_add(1, std::memory_order_relaxed);
+    } while (id == 0);  // skip 0 if the count wraps around
+    return id;
+}
+
 std::shared_ptr<GPath> GPath::transform(const GMatrix& m) const {
     if (fPts.empty() || is_identity(m)) {
         return const_cast<GPath*>(this)->shared_from_this();
     }
     std::vector<GPoint> dst(fPts.size());
     m.mapPoints(dst.data(), fPts.data(), fPts.size());
-    return std::make_shared<GPath>(std::move(dst), fVbs);
+    auto path = std::make_shared<GPath>(std::move(dst), fVbs);
+    // affine matrices keep convex paths convex (possibly degenerate), and concave ones concave
+    path->fConvexity.store(fConvexity.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return path;
+}
+
+// One kMove, then only kLines: a polygon, whose points are all on its outline. (Control points
+// of any other verb are not, so a contour with them is not a polygon of its points.)
+static bool is_single_contour(const std::vector<GPathVerb>& vbs) {
+    if (vbs.empty() || vbs[0] != GPathVerb::kMove) {
+        return false;
+    }
+    return std::all_of(vbs.begin() + 1, vbs.end(), [](GPathVerb v) {
+        return v == GPathVerb::kLine;
+    });
+}
+
+static int sign_of(float x) {
+    return (x > 0) - (x < 0);
+}
+
+// Number of times the sign changes going around the (cyclic) sequence, ignoring zeros
+static int count_sign_changes(const std::vector<int>& signs) {
+    int first = 0, prev = 0, changes = 0;
+    for (int s : signs) {
+        if (s == 0) {
+            continue;
+        }
+        if (prev == 0) {
+            first = s;
+        } else if (s != prev) {
+            changes += 1;
+        }
+        prev = s;
+    }
+    return changes + (prev != first);
+}
+
+GPath::Convexity GPath::computeConvexity() const {
+    const size_t n = fPts.size();
+    if (fVbs.empty()) {
+        return kConvex_Convexity;
+    }
+    if (!is_single_contour(fVbs)) {
+        return kConcave_Convexity;
+    }
+
+    // the edges of the closed contour, skipping zero-length ones
+    std::vector<GVector> edges;
+    for (size_t i = 0; i < n; ++i) {
+        const GPoint p0 = fPts[i], p1 = fPts[(i + 1) % n];
+        if (!std::isfinite(p0.x) || !std::isfinite(p0.y)) {
+            return kConcave_Convexity;
+        }
+        if (p0.x != p1.x || p0.y != p1.y) {
+            edges.push_back(p1 - p0);
+        }
+    }
+
+    // the same turn at every corner...
+    int turn = 0;
+    std::vector<int> dx, dy;
+    for (size_t i = 0; i < edges.size(); ++i) {
+        const GVector e0 = edges[i], e1 = edges[(i + 1) % edges.size()];
+        const int s = sign_of(e0.x * e1.y - e0.y * e1.x);
+        if (s != 0) {
+            if (turn != 0 && s != turn) {
+                return kConcave_Convexity;
+            }
+            turn = s;
+        }
+        dx.push_back(sign_of(e0.x));
+        dy.push_back(sign_of(e0.y));
+    }
+    // ...and only once around (e.g. not a star, which also always turns the same way)
+    if (count_sign_changes(dx) > 2 || count_sign_changes(dy) > 2) {
+        return kConcave_Convexity;
+    }
+    return kConvex_Convexity;
+}
+
+bool GPath::isConvex() const {
+    int8_t c = fConvexity.load(std::memory_order_relaxed);
+    if (c == kUnknown_Convexity) {
+        c = this->computeConvexity();   // racing threads compute the same answer
+        fConvexity.store(c, std::memory_order_relaxed);
+    }
+    return c == kConvex_Convexity;
 }
 
 GPath::Iter::Iter(const GPath& path) {
@@ -104,3 +203,7 @@ nonstd::optional<GPathVerb> GPath::Edger::next(GPoint pts[]) {
         return {};
     }
 }
+
+bool GPath::isRect(GRect* rect) const {
+    return is_single_contour(fVbs) && GPolygonIsAxisRect(fPts.data(), (int)fPts.size(), rect);
+}
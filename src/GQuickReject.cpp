@@ -0,0 +1,52 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GQuickReject.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+static std::atomic<int> gRejectCount{0};
+static std::atomic<int> gAcceptCount{0};
+
+static bool reject(const GRect& r, const GMatrix& ctm, const GIRect& clip) {
+    if (clip.isEmpty() || r.isEmpty()) {
+        return true;
+    }
+    GPoint pts[4] = {{r.left, r.top}, {r.right, r.top}, {r.right, r.bottom}, {r.left, r.bottom}};
+    ctm.mapPoints(pts, 4);
+
+    for (const GPoint& p : pts) {
+        if (!std::isfinite(p.x) || !std::isfinite(p.y)) {
+            return false;
+        }
+    }
+    float L = pts[0].x, T = pts[0].y, R = L, B = T;
+    for (int i = 1; i < 4; ++i) {
+        L = std::min(L, pts[i].x);
+        T = std::min(T, pts[i].y);
+        R = std::max(R, pts[i].x);
+        B = std::max(B, pts[i].y);
+    }
+    return R <= clip.left || L >= clip.right || B <= clip.top || T >= clip.bottom;
+}
+
+bool GQuickReject(const GRect& bounds, const GMatrix& ctm, const GIRect& clipBounds) {
+    const bool rejected = reject(bounds, ctm, clipBounds);
+    (rejected ? gRejectCount : gAcceptCount).fetch_add(1, std::memory_order_relaxed);
+    return rejected;
+}
+
+int GQuickReject_RejectCount() {
+    return gRejectCount.load(std::memory_order_relaxed);
+}
+
+int GQuickReject_AcceptCount() {
+    return gAcceptCount.load(std::memory_order_relaxed);
+}
+
+void GQuickReject_ResetCounts() {
+    gRejectCount.store(0, std::memory_order_relaxed);
+    gAcceptCount.store(0, std::memory_order_relaxed);
+}
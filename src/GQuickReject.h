@@ -0,0 +1,30 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GQuickReject_DEFINED
+#define GQuickReject_DEFINED
+
+#include "../include/GMatrix.h"
+#include "../include/GRect.h"
+
+/**
+ *  Return true if nothing inside bounds (in local coordinates), mapped by ctm, can touch a
+ *  pixel inside clipBounds (in device coordinates). A canvas calls this with the bounds of a
+ *  draw (e.g. GPath::bounds()) before building edges or setting up a shader, and skips the
+ *  draw if it returns true.
+ *
+ *  This is conservative: false does not mean a pixel will be drawn. Antialiased edges may
+ *  touch pixels whose centers are outside the bounds, so only bounds that end at or before
+ *  the edge of clipBounds are rejected. Bounds that are not finite are never rejected.
+ *
+ *  Each call counts as a reject or an accept.
+ */
+bool GQuickReject(const GRect& bounds, const GMatrix& ctm, const GIRect& clipBounds);
+
+// Counts are for all threads, since the last reset.
+int  GQuickReject_RejectCount();
+int  GQuickReject_AcceptCount();
+void GQuickReject_ResetCounts();
+
+#endif
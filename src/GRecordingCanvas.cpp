@@ -0,0 +1,219 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "../include/GRecordingCanvas.h"
+#include "../include/GPath.h"
+
+struct GDisplayList::Rec {
+    const Op fOp;
+};
+
+namespace {
+
+using Op = GDisplayList::Op;
+
+struct Save : GDisplayList::Rec {
+    static constexpr Op kOp = Op::kSave;
+    Save() : Rec{kOp} {}
+};
+
+struct Restore : GDisplayList::Rec {
+    static constexpr Op kOp = Op::kRestore;
+    Restore() : Rec{kOp} {}
+};
+
+struct Concat : GDisplayList::Rec {
+    static constexpr Op kOp = Op::kConcat;
+    Concat(const GMatrix& m) : Rec{kOp}, fMatrix(m) {}
+    const GMatrix fMatrix;
+};
+
+struct ClipRect : GDisplayList::Rec {
+    static constexpr Op kOp = Op::kClipRect;
+    ClipRect(const GRect& r) : Rec{kOp}, fRect(r) {}
+    const GRect fRect;
+};
+
+struct ClipPath : GDisplayList::Rec {
+    static constexpr Op kOp = Op::kClipPath;
+    ClipPath(std::shared_ptr<GPath> path) : Rec{kOp}, fPath(std::move(path)) {}
+    const std::shared_ptr<GPath> fPath;
+};
+
+struct Clear : GDisplayList::Rec {
+    static constexpr Op kOp = Op::kClear;
+    Clear(const GColor& c) : Rec{kOp}, fColor(c) {}
+    const GColor fColor;
+};
+
+struct DrawRect : GDisplayList::Rec {
+    static constexpr Op kOp = Op::kDrawRect;
+    DrawRect(const GRect& r, const GPaint& p) : Rec{kOp}, fRect(r), fPaint(p) {}
+    const GRect  fRect;
+    const GPaint fPaint;
+};
+
+struct DrawConvexPolygon : GDisplayList::Rec {
+    static constexpr Op kOp = Op::kDrawConvexPolygon;
+    DrawConvexPolygon(const GPoint* pts, int count, const GPaint& p)
+        : Rec{kOp}, fPts(pts), fCount(count), fPaint(p) {}
+    const GPoint* fPts;     // also lives in the arena
+    const int     fCount;
+    const GPaint  fPaint;
+};
+
+struct DrawPath : GDisplayList::Rec {
+    static constexpr Op kOp = Op::kDrawPath;
+    DrawPath(std::shared_ptr<GPath> path, const GPaint& p)
+        : Rec{kOp}, fPath(std::move(path)), fPaint(p) {}
+    const std::shared_ptr<GPath> fPath;
+    const GPaint                 fPaint;
+};
+
+template <typename T> const T& as(const GDisplayList::Rec* rec) {
+    assert(rec->fOp == T::kOp);
+    return *static_cast<const T*>(rec);
+}
+
+}  // namespace
+
+GDisplayList::Op GDisplayList::op(int index) const {
+    assert(index >= 0 && index < this->count());
+    return fRecs[index]->fOp;
+}
+
+void GDisplayList::playback(GCanvas* canvas) const {
+    canvas->save();
+    int saveCount = 0;
+    for (const Rec* rec : fRecs) {
+        switch (rec->fOp) {
+            case Op::kSave:
+                saveCount += 1;
+                canvas->save();
+                break;
+            case Op::kRestore:
+                assert(saveCount > 0);  // the recorder drops unmatched restores
+                saveCount -= 1;
+                canvas->restore();
+                break;
+            case Op::kConcat:
+                canvas->concat(as<Concat>(rec).fMatrix);
+                break;
+            case Op::kClipRect:
+                canvas->clipRect(as<ClipRect>(rec).fRect);
+                break;
+            case Op::kClipPath:
+                canvas->clipPath(*as<ClipPath>(rec).fPath);
+                break;
+            case Op::kClear:
+                canvas->clear(as<Clear>(rec).fColor);
+                break;
+            case Op::kDrawRect: {
+                const auto& r = as<DrawRect>(rec);
+                canvas->drawRect(r.fRect, r.fPaint);
+            } break;
+            case Op::kDrawConvexPolygon: {
+                const auto& r = as<DrawConvexPolygon>(rec);
+                canvas->drawConvexPolygon(r.fPts, r.fCount, r.fPaint);
+            } break;
+            case Op::kDrawPath: {
+                const auto& r = as<DrawPath>(rec);
+                canvas->drawPath(*r.fPath, r.fPaint);
+            } break;
+        }
+    }
+    for (; saveCount > 0; --saveCount) {
+        canvas->restore();
+    }
+    canvas->restore();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+GRecordingCanvas::GRecordingCanvas() : fList(new GDisplayList) {}
+
+GRecordingCanvas::~GRecordingCanvas() {}
+
+template <typename T, typename... Args> void GRecordingCanvas::append(Args&&... args) {
+    fList->fRecs.push_back(fList->fArena.make<T>(std::forward<Args>(args)...));
+}
+
+void GRecordingCanvas::save() {
+    fSaveCount += 1;
+    this->append<Save>();
+}
+
+void GRecordingCanvas::restore() {
+    if (fSaveCount == 0) {
+        return; // would pop the save that playback() wraps around the list
+    }
+    fSaveCount -= 1;
+    this->append<Restore>();
+}
+
+void GRecordingCanvas::concat(const GMatrix& m) {
+    this->append<Concat>(m);
+}
+
+void GRecordingCanvas::clipRect(const GRect& r) {
+    this->append<ClipRect>(r);
+}
+
+void GRecordingCanvas::clipPath(const GPath& path) {
+    this->append<ClipPath>(this->sharedPath(path));
+}
+
+void GRecordingCanvas::clear(const GColor& c) {
+    this->append<Clear>(c);
+}
+
+void GRecordingCanvas::drawRect(const GRect& r, const GPaint& p) {
+    this->append<DrawRect>(r, p);
+}
+
+void GRecordingCanvas::drawConvexPolygon(const GPoint pts[], int count, const GPaint& p) {
+    if (count < 3) {
+        return; // nothing would be drawn
+    }
+    this->append<DrawConvexPolygon>(fList->fArena.copyArray(pts, count), count, p);
+}
+
+void GRecordingCanvas::drawPath(const GPath& path, const GPaint& p) {
+    this->append<DrawPath>(this->sharedPath(path), p);
+}
+
+// Paths are immutable, but the caller may not own this one with a shared_ptr, so we keep our
+// own copy. Paths with the same uniqueID() have the same points and verbs, so one copy serves
+// them all.
+std::shared_ptr<GPath> GRecordingCanvas::sharedPath(const GPath& path) {
+    auto iter = fPaths.find(path.uniqueID());
+    if (iter == fPaths.end()) {
+        iter = fPaths.insert({path.uniqueID(), {std::make_shared<GPath>(path), 0}}).first;
+    }
+    iter->second.fGeneration = fGeneration;
+    return iter->second.fPath;
+}
+
+std::unique_ptr<GDisplayList> GRecordingCanvas::finishRecording() {
+    std::unique_ptr<GDisplayList> list(fSpare ? fSpare.release() : new GDisplayList);
+    std::swap(list, fList);
+    fSaveCount = 0;
+
+    // keep just the copies that this list used, for the next one
+    for (auto iter = fPaths.begin(); iter != fPaths.end();) {
+        iter = iter->second.fGeneration == fGeneration ? std::next(iter) : fPaths.erase(iter);
+    }
+    fGeneration += 1;
+    return list;
+}
+
+void GRecordingCanvas::recycle(std::unique_ptr<GDisplayList> list) {
+    if (!list) {
+        return;
+    }
+    // drop the calls (and their references to the shared paths), but keep the storage
+    list->fRecs.clear();
+    list->fArena.reset();
+    fSpare = std::move(list);
+}
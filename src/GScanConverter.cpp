@@ -0,0 +1,288 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GScanConverter.h"
+#include "../include/GMath.h"
+#include "../include/GMatrix.h"
+#include "../include/GPath.h"
+#include <algorithm>
+#include <cmath>
+
+void GScanConverter::fill(GEdge edges[], int count, const GIRect& clip, GBlitter* blitter) {
+    std::sort(edges, edges + count, [](const GEdge& a, const GEdge& b) {
+        return a.fTop < b.fTop;
+    });
+
+    fActive.clear();
+    int next = 0;   // the first edge that is not active yet
+    for (int y = clip.top; y < clip.bottom; ++y) {
+        if (fActive.empty()) {
+            if (next == count) {
+                break;
+            }
+            y = std::max(y, edges[next].fTop);  // skip the rows that no edge crosses
+            if (y >= clip.bottom) {
+                break;
+            }
+        }
+        for (; next < count && edges[next].fTop <= y; ++next) {
+            GEdge edge = edges[next];
+            if (edge.fBottom > y) {
+                edge.fX += (GFixed)((int64_t)edge.fDX * (y - edge.fTop));  // if it starts above
+                fActive.push_back(edge);
+            }
+        }
+        fActive.erase(std::remove_if(fActive.begin(), fActive.end(), [y](const GEdge& e) {
+            return e.fBottom <= y;
+        }), fActive.end());
+
+        fCrossings.clear();
+        for (GEdge& edge : fActive) {
+            fCrossings.push_back({edge.fX, edge.fWinding});
+            edge.fX += edge.fDX;
+        }
+        std::sort(fCrossings.begin(), fCrossings.end());
+
+        int winding = 0;
+        GFixed start = 0;
+        for (const Crossing& c : fCrossings) {
+            const int prevWinding = winding;
+            winding += c.fWinding;
+            if (prevWinding == 0 && winding != 0) {
+                start = c.fX;
+            } else if (prevWinding != 0 && winding == 0) {
+                const int L = std::max(GFixedRoundToInt(start), clip.left),
+                          R = std::min(GFixedRoundToInt(c.fX), clip.right);
+                if (L < R) {
+                    blitter->blitH(L, y, R - L);
+                }
+            }
+        }
+    }
+}
+
+void GScanConverter::fillPath(const GPath& path, const GMatrix& ctm, const GIRect& clip,
+                              GBlitter* blitter) {
+    const int maxCount = GMaxEdgeCount(path);
+    if ((int)fEdges.size() < maxCount) {
+        fEdges.resize(maxCount);
+    }
+    const int count = GBuildEdges(path, ctm, fEdges.data());
+    this->fill(fEdges.data(), count, clip, blitter);
+}
+
+void GScanConverter::addLine(GPoint p0, GPoint p1, float left, float right) {
+    if (p0.y == p1.y || !std::isfinite(p0.x + p0.y + p1.x + p1.y)) {
+        return;     // horizontal lines cover nothing
+    }
+    float dir = 1;
+    if (p0.y > p1.y) {
+        std::swap(p0, p1);
+        dir = -1;
+    }
+
+    // Split where the line crosses left and right. The pieces on the left move onto it: they
+    // still carry their cover to every cell. The pieces on the right touch no cell.
+    float ts[4] = {0};
+    int n = 1;
+    for (float x : {left, right}) {
+        if ((p0.x < x) != (p1.x < x)) {
+            ts[n++] = (x - p0.x) / (p1.x - p0.x);
+        }
+    }
+    ts[n++] = 1;
+    std::sort(ts, ts + n);
+
+    const float dx = p1.x - p0.x, dy = p1.y - p0.y;
+    for (int i = 0; i + 1 < n; ++i) {
+        const float y0 = p0.y + dy * ts[i],
+                    y1 = i + 2 == n ? p1.y : p0.y + dy * ts[i + 1];
+        if (!(y0 < y1)) {
+            continue;
+        }
+        float x0 = p0.x + dx * ts[i],
+              x1 = p0.x + dx * ts[i + 1];
+        const float mid = (x0 + x1) * 0.5f;
+        if (mid >= right) {
+            continue;
+        }
+        if (mid <= left) {
+            x0 = x1 = left;
+        }
+        x0 = std::min(std::max(x0, left), right) - left;
+        x1 = std::min(std::max(x1, left), right) - left;
+        fLines.push_back({x0, y0, x1, y1, (x1 - x0) / (y1 - y0), dir});
+    }
+}
+
+void GScanConverter::accumulate(const Line& line, int y, int width) {
+    const float ya = std::max((float)y, line.fY0),
+                yb = std::min((float)(y + 1), line.fY1);
+    if (ya >= yb) {
+        return;
+    }
+    const float w = (float)width;
+    const float xa = std::min(std::max(line.fX0 + (ya - line.fY0) * line.fDXDY, 0.0f), w),
+                xb = std::min(std::max(line.fX0 + (yb - line.fY0) * line.fDXDY, 0.0f), w);
+    const float d = (yb - ya) * line.fDir;     // the cover this piece carries to its right
+
+    // The piece's area goes into the cells it crosses, the rest of d into the next cell, so
+    // that the running sum adds up to d from there on.
+    const float x0 = std::min(xa, xb),
+                x1 = std::max(xa, xb);
+    const float x0floor = std::floor(x0);
+    const int   x0i = (int)x0floor,
+                x1i = (int)std::ceil(x1);
+    float* cells = fCells.data();
+    if (x1i <= x0i + 1) {
+        // inside one cell: the area right of the piece is its cover times how far it is from
+        // the right of the cell
+        const float xmf = (xa + xb) * 0.5f - x0floor;
+        cells[x0i]     += d - d * xmf;
+        cells[x0i + 1] += d * xmf;
+    } else {
+        // across several cells: the area grows quadratically in the first and last cells, and
+        // by the same amount in each one between
+        const float s = 1 / (x1 - x0);
+        const float x0f = x0 - x0floor;
+        const float a0 = 0.5f * s * (1 - x0f) * (1 - x0f);
+        const float x1f = x1 - x1i + 1;
+        const float am = 0.5f * s * x1f * x1f;
+        cells[x0i] += d * a0;
+        if (x1i == x0i + 2) {
+            cells[x0i + 1] += d * (1 - a0 - am);
+        } else {
+            const float a1 = s * (1.5f - x0f);
+            cells[x0i + 1] += d * (a1 - a0);
+            for (int x = x0i + 2; x < x1i - 1; ++x) {
+                cells[x] += d * s;
+            }
+            const float a2 = a1 + (x1i - x0i - 3) * s;
+            cells[x1i - 1] += d * (1 - a2 - am);
+        }
+        cells[x1i] += d * am;
+    }
+    fMinCell = std::min(fMinCell, x0i);
+    fMaxCell = std::max(fMaxCell, x1i + 1);
+}
+
+const GAlphaRun* GScanConverter::finishRow(int width, int* x) {
+    GAlphaRun* runs = fRuns.data();
+    int count = 0;
+    auto append = [&](int n, float acc) {
+        const uint8_t alpha = (uint8_t)GRoundToInt(std::min(std::abs(acc), 1.0f) * 255);
+        if (count > 0 && runs[count - 1].fAlpha == alpha && runs[count - 1].fCount + n <= 0xFFFF) {
+            runs[count - 1].fCount += n;
+        } else {
+            runs[count++] = {(uint16_t)n, alpha};
+        }
+    };
+
+    // the cells left of fMinCell are 0, and from fMaxCell on, the coverage no longer changes
+    const int start = std::min(fMinCell, width),
+              stop = std::min(fMaxCell, width);
+    float acc = 0;
+    for (int i = start; i < stop; ++i) {
+        acc += fCells[i];
+        append(1, acc);
+    }
+    if (stop < width) {
+        append(width - stop, acc);
+    }
+    if (fMinCell < fMaxCell) {
+        std::fill(fCells.begin() + fMinCell, fCells.begin() + fMaxCell, 0.0f);
+    }
+    fMinCell = (int)fCells.size();
+    fMaxCell = 0;
+
+    // trim the uncovered ends
+    if (count > 0 && runs[count - 1].fAlpha == 0) {
+        count -= 1;
+    }
+    *x = start;
+    if (count > 0 && runs[0].fAlpha == 0) {
+        *x += runs[0].fCount;
+        runs += 1;
+        count -= 1;
+    }
+    runs[count].fCount = 0;
+    return count > 0 ? runs : nullptr;
+}
+
+void GScanConverter::fillPathAntiAlias(const GPath& path, const GMatrix& ctm, const GIRect& clip,
+                                       GBlitter* blitter) {
+    GPoint pts[GPath::kMaxNextPoints];
+    float l = INFINITY, t = INFINITY, r = -INFINITY, b = -INFINITY;
+    {
+        GPath::Edger edger(path);
+        while (edger.next(pts)) {
+            ctm.mapPoints(pts, 2);
+            for (int i = 0; i < 2; ++i) {
+                l = std::min(l, pts[i].x);
+                t = std::min(t, pts[i].y);
+                r = std::max(r, pts[i].x);
+                b = std::max(b, pts[i].y);
+            }
+        }
+    }
+    if (!(l <= r)) {
+        return;
+    }
+    // the cells are the columns of the clip that the path touches
+    const int left   = std::max(clip.left,   (int)std::max(std::floor(l), -1e9f)),
+              top    = std::max(clip.top,    (int)std::max(std::floor(t), -1e9f)),
+              right  = std::min(clip.right,  (int)std::min(std::ceil(r), 1e9f)),
+              bottom = std::min(clip.bottom, (int)std::min(std::ceil(b), 1e9f));
+    if (left >= right || top >= bottom) {
+        return;
+    }
+    const int width = right - left;
+
+    fLines.clear();
+    GPath::Edger edger(path);
+    while (edger.next(pts)) {
+        ctm.mapPoints(pts, 2);
+        this->addLine(pts[0], pts[1], (float)left, (float)right);
+    }
+    std::sort(fLines.begin(), fLines.end(), [](const Line& a, const Line& b) {
+        return a.fY0 < b.fY0;
+    });
+
+    // two extra cells: the ones right of a piece on the right edge
+    if ((int)fCells.size() < width + 2) {
+        fCells.resize(width + 2);
+        fRuns.resize(width + 1);
+    }
+    fMinCell = (int)fCells.size();
+    fMaxCell = 0;
+
+    fActiveLines.clear();
+    const int count = (int)fLines.size();
+    int next = 0;
+    for (int y = top; y < bottom; ++y) {
+        if (fActiveLines.empty()) {
+            if (next == count) {
+                break;
+            }
+            y = std::max(y, (int)std::floor(fLines[next].fY0));
+            if (y >= bottom) {
+                break;
+            }
+        }
+        for (; next < count && fLines[next].fY0 < y + 1; ++next) {
+            fActiveLines.push_back(fLines[next]);
+        }
+        fActiveLines.erase(std::remove_if(fActiveLines.begin(), fActiveLines.end(),
+                                          [y](const Line& line) { return line.fY1 <= y; }),
+                           fActiveLines.end());
+
+        for (const Line& line : fActiveLines) {
+            this->accumulate(line, y, width);
+        }
+        int x;
+        if (const GAlphaRun* runs = this->finishRow(width, &x)) {
+            blitter->blitAntiH(left + x, y, runs);
+        }
+    }
+}
@@ -0,0 +1,95 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#ifndef GScanConverter_DEFINED
+#define GScanConverter_DEFINED
+
+#include "GBlitter.h"
+#include "GEdge.h"
+#include <vector>
+
+class GMatrix;
+class GPath;
+
+/**
+ *  Fills edges (see GEdge) with winding fill (non-zero), sampling at pixel centers: the edges
+ *  are sorted by their top row, and walked down the rows with a list of the active ones. Each
+ *  row's crossings are sorted by x, and the spans where the winding is not zero go to
+ *  GBlitter::blitH(), top to bottom, and left to right within a row.
+ *
+ *  Clips (GClipStack) and draws use the same converter, so a path clip covers exactly the
+ *  pixels that drawing the path would.
+ *
+ *  fillPathAntiAlias() is the anti-aliased version: instead of sampling pixel centers, it finds
+ *  the exact area of each pixel that the path covers.
+ *
+ *  A converter keeps its scratch storage (the edges or lines of a path, the active list, and a
+ *  row's crossings or cells), so once it has grown to fit the largest path, it no longer
+ *  allocates. Each canvas (or thread) needs its own.
+ */
+class GScanConverter {
+public:
+    /**
+     *  Fill the edges, passing on only the parts of the spans inside clip. The edges are
+     *  reordered (sorted by fTop) in place.
+     */
+    void fill(GEdge edges[], int count, const GIRect& clip, GBlitter*);
+
+    // fill() the edges of the path mapped by ctm (see GBuildEdges())
+    void fillPath(const GPath&, const GMatrix& ctm, const GIRect& clip, GBlitter*);
+
+    /**
+     *  Fill the path mapped by ctm, giving each pixel the area of it inside the path, as font
+     *  rasterizers do: one row at a time, each line adds its signed area to the cells it
+     *  crosses, and the cover it carries to the cells on its right. A running sum along the
+     *  row is then the coverage, which goes to GBlitter::blitAntiH().
+     *
+     *  Where contours overlap (winding of 2 or more), the coverage is capped at full, which is
+     *  the non-zero rule except for pixels that an edge of each contour crosses.
+     */
+    void fillPathAntiAlias(const GPath&, const GMatrix& ctm, const GIRect& clip, GBlitter*);
+
+    // A clip that keeps every span: edges never go past +-GEdge::kMaxCoord (e.g. for masks)
+    static GIRect NoClip() {
+        return GIRect::LTRB(-GEdge::kMaxCoord, -GEdge::kMaxCoord,
+                            GEdge::kMaxCoord, GEdge::kMaxCoord);
+    }
+
+private:
+    struct Crossing {
+        GFixed fX;
+        int    fWinding;
+
+        bool operator<(const Crossing& c) const {
+            return fX < c.fX || (fX == c.fX && fWinding < c.fWinding);
+        }
+    };
+
+    // A piece of a line for fillPathAntiAlias(), with x relative to the left of the cells
+    struct Line {
+        float fX0, fY0;     // fY0 < fY1
+        float fX1, fY1;
+        float fDXDY;
+        float fDir;         // +1 if the line goes down, -1 if it goes up
+    };
+
+    // Add the line to fLines, split so that each piece is inside [left, right] of the cells
+    void addLine(GPoint p0, GPoint p1, float left, float right);
+    // Add the part of the line in row y to the first width (+ 2) fCells
+    void accumulate(const Line&, int y, int width);
+    // Turn fCells (and the coverage they carry on to the right) into runs, and clear them
+    const GAlphaRun* finishRow(int width, int* x);
+
+    std::vector<GEdge>     fEdges;      // for fillPath()
+    std::vector<GEdge>     fActive;
+    std::vector<Crossing>  fCrossings;
+
+    std::vector<Line>      fLines;      // for fillPathAntiAlias()
+    std::vector<Line>      fActiveLines;
+    std::vector<float>     fCells;
+    std::vector<GAlphaRun> fRuns;
+    int                    fMinCell, fMaxCell;     // the cells touched in this row
+};
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "../include/GThreadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+struct GThreadPool::Impl {
+    // Tasks that are waited for together: those from add(), or from one parallelFor()
+    struct Group {
+        std::atomic<int> fPending{0};   // tasks added but not yet finished
+    };
+    struct Task {
+        std::function<void()> fFn;
+        Group*                fGroup;
+    };
+    struct Queue {
+        std::mutex       fMutex;
+        std::deque<Task> fTasks;
+    };
+
+    // one queue per worker, plus one (the last) for threads that wait
+    std::vector<std::unique_ptr<Queue>> fQueues;
+    std::vector<std::thread>            fThreads;
+
+    std::mutex              fMutex;
+    std::condition_variable fWorkAvailable;
+    std::condition_variable fGroupDone;     // or more work was queued
+    std::atomic<int>        fQueued{0};     // tasks added but not yet taken
+    Group                   fAdded;         // from add()
+    std::atomic<unsigned>   fNextQueue{0};
+    bool                    fQuit = false;
+
+    // Pop from the back of our own queue, else steal from the front of someone else's.
+    bool take(int self, Task* task) {
+        const int n = (int)fQueues.size();
+        for (int i = 0; i < n; ++i) {
+            Queue* q = fQueues[(self + i) % n].get();
+            std::lock_guard<std::mutex> lock(q->fMutex);
+            if (!q->fTasks.empty()) {
+                if (i == 0) {
+                    *task = std::move(q->fTasks.back());
+                    q->fTasks.pop_back();
+                } else {
+                    *task = std::move(q->fTasks.front());
+                    q->fTasks.pop_front();
+                }
+                fQueued -= 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void push(Group* group, std::function<void()> fn) {
+        const unsigned index = fNextQueue++ % fQueues.size();
+        group->fPending += 1;
+        {
+            Queue* q = fQueues[index].get();
+            std::lock_guard<std::mutex> lock(q->fMutex);
+            q->fTasks.push_back({std::move(fn), group});
+            fQueued += 1;
+        }
+        std::lock_guard<std::mutex> lock(fMutex);
+        fWorkAvailable.notify_one();
+        fGroupDone.notify_all();    // a thread in waitFor() may be able to help
+    }
+
+    void run(Task& task) {
+        task.fFn();
+        task.fFn = nullptr;
+        if (--task.fGroup->fPending == 0) {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fGroupDone.notify_all();
+        }
+    }
+
+    // Run any tasks (not just the group's) until the group's have all finished
+    void waitFor(Group* group) {
+        const int self = (int)fQueues.size() - 1;
+        Task task;
+        while (group->fPending > 0) {
+            if (this->take(self, &task)) {
+                this->run(task);
+                continue;
+            }
+            // everything is taken, just not finished yet
+            std::unique_lock<std::mutex> lock(fMutex);
+            fGroupDone.wait(lock, [this, group]() {
+                return group->fPending == 0 || fQueued > 0;
+            });
+        }
+    }
+
+    void loop(int self) {
+        Task task;
+        for (;;) {
+            if (this->take(self, &task)) {
+                this->run(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(fMutex);
+            fWorkAvailable.wait(lock, [this]() { return fQuit || fQueued > 0; });
+            if (fQuit) {
+                return;
+            }
+        }
+    }
+};
+
+GThreadPool::GThreadPool(int threadCount)
+    : fImpl(new Impl)
+    , fThreadCount(std::max(threadCount, 1))
+{
+    const int workers = fThreadCount > 1 ? fThreadCount : 0;
+    for (int i = 0; i <= workers; ++i) {
+        fImpl->fQueues.emplace_back(new Impl::Queue);
+    }
+    for (int i = 0; i < workers; ++i) {
+        fImpl->fThreads.emplace_back([this, i]() { fImpl->loop(i); });
+    }
+}
+
+GThreadPool::~GThreadPool() {
+    this->wait();
+    {
+        std::lock_guard<std::mutex> lock(fImpl->fMutex);
+        fImpl->fQuit = true;
+    }
+    fImpl->fWorkAvailable.notify_all();
+    for (auto& t : fImpl->fThreads) {
+        t.join();
+    }
+}
+
+void GThreadPool::add(std::function<void()> task) {
+    fImpl->push(&fImpl->fAdded, std::move(task));
+}
+
+void GThreadPool::wait() {
+    fImpl->waitFor(&fImpl->fAdded);
+}
+
+void GThreadPool::parallelFor(int count, const std::function<void(int)>& fn) {
+    Impl::Group group;
+    for (int i = 0; i < count; ++i) {
+        fImpl->push(&group, [&fn, i]() { fn(i); });
+    }
+    fImpl->waitFor(&group);
+}
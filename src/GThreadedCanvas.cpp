@@ -0,0 +1,121 @@
+/**
+ *  Copyright 2024 Mike Reed
+ */
+
+#include "GBandReplay.h"
+#include "../include/GCanvas.h"
+#include "../include/GPath.h"
+#include "../include/GRecordingCanvas.h"
+#include "../include/GThreadPool.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+/*
+ *  Records the calls, and at flush() plays them back into one band of rows per thread, all at
+ *  the same time (see GReplayInBands()). Each band draws into its own GCreateCanvas(), so this
+ *  works with any canvas.
+ *
+ *  The bands' canvases only last for one flush, so the saves, concats and clips that are still
+ *  in effect are kept, and recorded again at the start of the next recording.
+ */
+class ThreadedCanvas : public GCanvas {
+public:
+    ThreadedCanvas(const GBitmap& bitmap, int threadCount)
+        : fBitmap(bitmap), fPool(threadCount), fBandCount(threadCount) {}
+
+    ~ThreadedCanvas() override { this->flush(); }
+
+    void save() override {
+        fState.push_back({StateOp::kSave, GMatrix(), GRect(), nullptr});
+        fRecorder.save();
+    }
+    void restore() override {
+        auto save = std::find_if(fState.rbegin(), fState.rend(), [](const StateOp& op) {
+            return op.fKind == StateOp::kSave;
+        });
+        if (save == fState.rend()) {
+            return;     // no matching save
+        }
+        fState.erase(std::next(save).base(), fState.end());
+        fRecorder.restore();
+    }
+    void concat(const GMatrix& m) override {
+        fState.push_back({StateOp::kConcat, m, GRect(), nullptr});
+        fRecorder.concat(m);
+    }
+    void clipRect(const GRect& r) override {
+        fState.push_back({StateOp::kClipRect, GMatrix(), r, nullptr});
+        fRecorder.clipRect(r);
+    }
+    void clipPath(const GPath& path) override {
+        fState.push_back({StateOp::kClipPath, GMatrix(), GRect(), std::make_shared<GPath>(path)});
+        fRecorder.clipPath(path);
+    }
+
+    void clear(const GColor& c) override {
+        fDrawn = true;
+        fRecorder.clear(c);
+    }
+    void drawRect(const GRect& r, const GPaint& p) override {
+        fDrawn = true;
+        fRecorder.drawRect(r, p);
+    }
+    void drawConvexPolygon(const GPoint pts[], int count, const GPaint& p) override {
+        fDrawn = true;
+        fRecorder.drawConvexPolygon(pts, count, p);
+    }
+    void drawPath(const GPath& path, const GPaint& p) override {
+        fDrawn = true;
+        fRecorder.drawPath(path, p);
+    }
+
+    void flush() override {
+        if (!fDrawn) {
+            return;     // the recording only has state, which is still needed
+        }
+        auto list = fRecorder.finishRecording();
+        GReplayInBands(*list, fBitmap, fBandCount, &fPool);
+        fRecorder.recycle(std::move(list));
+        fDrawn = false;
+
+        // start the next recording in the state the calls so far have left
+        for (const StateOp& op : fState) {
+            switch (op.fKind) {
+                case StateOp::kSave:     fRecorder.save();               break;
+                case StateOp::kConcat:   fRecorder.concat(op.fMatrix);   break;
+                case StateOp::kClipRect: fRecorder.clipRect(op.fRect);   break;
+                case StateOp::kClipPath: fRecorder.clipPath(*op.fPath);  break;
+            }
+        }
+    }
+
+private:
+    // A call that changes the state of later draws
+    struct StateOp {
+        enum Kind { kSave, kConcat, kClipRect, kClipPath } fKind;
+        GMatrix                fMatrix;
+        GRect                  fRect;
+        std::shared_ptr<GPath> fPath;
+    };
+
+    const GBitmap         fBitmap;
+    GThreadPool           fPool;
+    const int             fBandCount;
+    GRecordingCanvas      fRecorder;
+    std::vector<StateOp>  fState;           // since the bottom of the save stack
+    bool                  fDrawn = false;   // anything to flush()
+};
+
+}  // namespace
+
+std::unique_ptr<GCanvas> GCreateCanvas(const GBitmap& bitmap, int threadCount) {
+    if (threadCount <= 1) {
+        return GCreateCanvas(bitmap);
+    }
+    if (bitmap.width() <= 0 || bitmap.height() <= 0 || !bitmap.pixels()) {
+        return nullptr;
+    }
+    return std::unique_ptr<GCanvas>(new ThreadedCanvas(bitmap, threadCount));
+}